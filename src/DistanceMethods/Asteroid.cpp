@@ -1,6 +1,7 @@
 #include "Asteroid.hpp"
 #include <DistanceMethods/MiniNJ.hpp>
 #include <IO/Logger.hpp>
+#include <IO/NewickTreeReader.hpp>
 #include <limits>
 #include <parallelization/PerCoreGeneTrees.hpp>
 #include <search/UNNISearch.hpp>
@@ -148,10 +149,9 @@ Asteroid::Asteroid(const PLLUnrootedTree &speciesTree, const Families &families,
       _perFamilyCoverage[i][_speciesStringToSpeciesId.at(species)] = true;
     }
     coverageSet.insert(_perFamilyCoverage[i]);
-    std::ifstream reader(family.startingGeneTree);
-    std::string geneTreeStr;
-    while (std::getline(reader, geneTreeStr)) {
-      PLLUnrootedTree geneTree(geneTreeStr, false);
+    NewickTreeReader reader(family.startingGeneTree);
+    while (reader.next()) {
+      PLLUnrootedTree geneTree(reader.parseUnrooted());
       MiniNJ::geneDistancesFromGeneTree(
           geneTree, mappings, _speciesStringToSpeciesId,
           _geneDistanceMatrices[i], _geneDistanceDenominators[i], minMode,
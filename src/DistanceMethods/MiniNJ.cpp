@@ -4,6 +4,7 @@
 #include <IO/Families.hpp>
 #include <IO/GeneSpeciesMapping.hpp>
 #include <IO/Logger.hpp>
+#include <IO/NewickTreeReader.hpp>
 #include <algorithm>
 #include <parallelization/ParallelContext.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
@@ -168,19 +169,10 @@ void MiniNJ::computeDistanceMatrix(
   for (auto &family : perCoreFamilies) {
     GeneSpeciesMapping mappings;
     mappings.fill(family.mappingFile, family.startingGeneTree);
-    std::ifstream reader(family.startingGeneTree);
-    std::string geneTreeStr;
-    std::vector<std::string> geneTreeStrings;
-    while (std::getline(reader, geneTreeStr)) {
-      geneTreeStrings.push_back(geneTreeStr);
-    }
-    if (geneTreeStrings[0][0] == '#') {
-      // this is a .ale file
-      geneTreeStrings[0] = geneTreeStrings[1];
-      geneTreeStrings.resize(1);
-    }
-    for (const auto &str : geneTreeStrings) {
-      PLLUnrootedTree geneTree(str, false);
+    // accept .ale files (only read their second line)
+    NewickTreeReader reader(family.startingGeneTree, true);
+    while (reader.next()) {
+      PLLUnrootedTree geneTree(reader.parseUnrooted());
       geneDistancesFromGeneTree(geneTree, mappings, speciesStringToSpeciesId,
                                 distanceMatrix, distanceDenominator, minMode,
                                 reweight, ustar, contractBranchUnder);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <IO/Logger.hpp>
+#include <algorithm>
 #include <string>
 #include <util/enums.hpp>
 
@@ -174,6 +175,55 @@ public:
     }
   }
 
+  /**
+   *  Parse the value of the species search multi-start option:
+   *  "GROUPS" or "GROUPS:ROUNDS", with positive integers
+   *  (see SpeciesTreeSearchParams)
+   */
+  static void strToMultiStart(const std::string &str, unsigned int &groups,
+                              unsigned int &rounds) {
+    auto separator = str.find(':');
+    auto groupsStr = str.substr(0, separator);
+    auto roundsStr =
+        separator == std::string::npos ? "1" : str.substr(separator + 1);
+    groups = strToPositiveInt(groupsStr);
+    rounds = strToPositiveInt(roundsStr);
+    if (!groups || !rounds) {
+      Logger::info << "Invalid multi-start search " << str
+                   << " (expected GROUPS or GROUPS:ROUNDS)" << std::endl;
+      exit(41);
+    }
+  }
+
+  /**
+   *  Parse the value of the gene search time budget option: a number
+   *  of seconds, optionally followed by the unit s, m or h (e.g. "90",
+   *  "30m", "1.5h"). Return the budget in seconds (0 for no budget)
+   */
+  static double strToTimeBudget(const std::string &str) {
+    double factor = 1.0;
+    auto valueStr = str;
+    auto unit = str.size() ? str.back() : ' ';
+    if (unit == 's' || unit == 'm' || unit == 'h') {
+      factor = (unit == 'h') ? 3600.0 : (unit == 'm') ? 60.0 : 1.0;
+      valueStr.pop_back();
+    }
+    double value = -1.0;
+    if (valueStr.size() &&
+        valueStr.find_first_not_of("0123456789.") == std::string::npos &&
+        std::count(valueStr.begin(), valueStr.end(), '.') <= 1 &&
+        valueStr != ".") {
+      value = std::stod(valueStr);
+    }
+    if (value < 0.0) {
+      Logger::info << "Invalid time budget " << str
+                   << " (expected SECONDS, or a number followed by s, m or h)"
+                   << std::endl;
+      exit(41);
+    }
+    return value * factor;
+  }
+
   static CCPRooting strToCCPRooting(const std::string &str) {
     if (str == "UNIFORM") {
       return CCPRooting::UNIFORM;
@@ -188,4 +238,14 @@ public:
       exit(41);
     }
   }
+
+private:
+  // return 0 if str is not a positive integer
+  static unsigned int strToPositiveInt(const std::string &str) {
+    if (str.empty() || str.size() > 9 ||
+        str.find_first_not_of("0123456789") != std::string::npos) {
+      return 0;
+    }
+    return static_cast<unsigned int>(std::stoul(str));
+  }
 };
@@ -0,0 +1,68 @@
+#include "AsyncFileWriter.hpp"
+
+#include <IO/Logger.hpp>
+#include <cstdio>
+#include <fstream>
+
+AsyncFileWriter::AsyncFileWriter()
+    : _writing(false), _stop(false), _thread(&AsyncFileWriter::run, this) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  _thread.join();
+}
+
+void AsyncFileWriter::write(const std::string &fileName, std::string content) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending[fileName] = std::move(content);
+  }
+  _cv.notify_all();
+}
+
+void AsyncFileWriter::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cv.wait(lock, [this] { return _pending.empty() && !_writing; });
+}
+
+void AsyncFileWriter::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _cv.wait(lock, [this] { return _stop || !_pending.empty(); });
+    if (_pending.empty()) {
+      // _stop is set and everything has been written
+      return;
+    }
+    auto pending = std::move(_pending);
+    _pending.clear();
+    _writing = true;
+    lock.unlock();
+    for (const auto &file : pending) {
+      writeAtomically(file.first, file.second);
+    }
+    lock.lock();
+    _writing = false;
+    _cv.notify_all();
+  }
+}
+
+void AsyncFileWriter::writeAtomically(const std::string &fileName,
+                                      const std::string &content) {
+  auto tempFileName = fileName + ".tmp";
+  {
+    std::ofstream os(tempFileName);
+    os << content;
+    if (!os) {
+      Logger::error << "Failed to write " << tempFileName << std::endl;
+      return;
+    }
+  }
+  if (std::rename(tempFileName.c_str(), fileName.c_str())) {
+    Logger::error << "Failed to rename " << tempFileName << " into "
+                  << fileName << std::endl;
+  }
+}
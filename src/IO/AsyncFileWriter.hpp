@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ *  Writes files from a background thread, such that the caller
+ *  never waits for the filesystem.
+ *  Successive writes to the same path that have not been processed
+ *  yet are coalesced: only the most recent content is written.
+ *  Each file is first written to a temporary file and then renamed,
+ *  so that readers never see a partially written file.
+ */
+class AsyncFileWriter {
+public:
+  AsyncFileWriter();
+
+  /**
+   *  Waits for all pending writes before returning
+   */
+  ~AsyncFileWriter();
+
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+  /**
+   *  Schedule the writing of content into fileName
+   */
+  void write(const std::string &fileName, std::string content);
+
+  /**
+   *  Block until all scheduled writes are on disk
+   */
+  void flush();
+
+private:
+  void run();
+  static void writeAtomically(const std::string &fileName,
+                              const std::string &content);
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::map<std::string, std::string> _pending;
+  bool _writing;
+  bool _stop;
+  std::thread _thread;
+};
@@ -5,8 +5,10 @@
 #include <IO/Logger.hpp>
 #include <IO/ParallelOfstream.hpp>
 #include <algorithm>
+#include <fstream>
 #include <likelihoods/LibpllEvaluation.hpp>
 #include <maths/Random.hpp>
+#include <parallelization/CostModel.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
 #include <trees/PLLRootedTree.hpp>
 
@@ -152,6 +154,24 @@ filterFamily(const FamilyInfo &family,
   return ERROR_OK;
 }
 
+static double getFileSize(const std::string &filePath) {
+  std::ifstream is(filePath, std::ios::binary | std::ios::ate);
+  if (!filePath.size() || !is.good()) {
+    return 0.0;
+  }
+  return static_cast<double>(is.tellg());
+}
+
+/**
+ *  Checking a family mostly means parsing its files, so we use
+ *  their total size as the cost of the family
+ */
+static double getFilterCost(const FamilyInfo &family) {
+  return getFileSize(family.alignmentFile) +
+         getFileSize(family.startingGeneTree) +
+         getFileSize(family.mappingFile);
+}
+
 void Family::filterFamilies(Families &families,
                             const std::string &speciesTreeFile,
                             bool checkAlignments, bool checkSpeciesTree) {
@@ -182,17 +202,18 @@ void Family::filterFamilies(Families &families,
     }
     LibpllParsers::fillLeavesFromRtree(speciesTree, speciesTreeLabels);
   }
-  std::vector<unsigned int> localErrors(
-      (initialFamilySize - 1) / ParallelContext::getSize() + 1, 99999999);
-  std::vector<unsigned int> errors;
-  for (auto i = ParallelContext::getBegin(initialFamilySize);
-       i < ParallelContext::getEnd(initialFamilySize); i++) {
-    auto &family = copy[i];
-    localErrors[i - ParallelContext::getBegin(initialFamilySize)] =
-        filterFamily(family, speciesTreeLabels, checkAlignments);
+  // the families are balanced across ranks with the cost model,
+  // and each error is only set by the rank that checked the family
+  // and summed, such that errors keep the order of the families
+  std::vector<double> costs;
+  for (const auto &family : copy) {
+    costs.push_back(getFilterCost(family));
+  }
+  std::vector<unsigned int> errors(initialFamilySize, ERROR_OK);
+  for (auto i : CostModel::getMyIndices(costs)) {
+    errors[i] = filterFamily(copy[i], speciesTreeLabels, checkAlignments);
   }
-  ParallelContext::concatenateUIntVectors(localErrors, errors);
-  errors.erase(remove(errors.begin(), errors.end(), 99999999), errors.end());
+  ParallelContext::sumVectorUInt(errors);
   Logger::info << std::endl;
   ParallelContext::barrier();
   for (unsigned int i = 0; i < initialFamilySize; ++i) {
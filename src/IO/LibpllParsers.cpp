@@ -1,4 +1,5 @@
 #include "LibpllParsers.hpp"
+#include <IO/GeneSpeciesMapping.hpp>
 #include <IO/LibpllException.hpp>
 #include <IO/Logger.hpp>
 #include <IO/RootedNewickParser.hpp>
@@ -224,6 +225,57 @@ LibpllParsers::parallelGetTreeSizes(const Families &families) {
   assert(treeSizes.size() == families.size());
   return treeSizes;
 }
+std::vector<FamilyCostFeatures>
+LibpllParsers::parallelGetCostFeatures(const Families &families,
+                                       bool withAlignments) {
+  const unsigned int featuresNumber = 4;
+  unsigned int familiesNumber = static_cast<unsigned int>(families.size());
+  // each family is only filled by one rank and zero elsewhere,
+  // so the sum keeps the order and the unknown (0) features
+  std::vector<unsigned int> values(familiesNumber * featuresNumber, 0);
+  for (auto i = ParallelContext::getBegin(familiesNumber);
+       i < ParallelContext::getEnd(familiesNumber); i++) {
+    auto &family = families[i];
+    auto *familyValues = &values[i * featuresNumber];
+    corax_utree_t *tree = readNewickFromFile(family.startingGeneTree);
+    std::unordered_set<std::string> labels;
+    fillLeavesFromUtree(tree, labels);
+    familyValues[0] = tree->tip_count;
+    corax_utree_destroy(tree, 0);
+    GeneSpeciesMapping mapping;
+    if (family.mappingFile.size()) {
+      mapping.fill(family.mappingFile, family.startingGeneTree);
+    } else {
+      mapping.fillFromGeneLabels(labels);
+    }
+    familyValues[1] =
+        static_cast<unsigned int>(mapping.getCoveredSpecies().size());
+    if (withAlignments && family.alignmentFile.size()) {
+      auto model = getModel(family.libpllModel);
+      PLLSequencePtrs sequences;
+      unsigned int *patternWeights = nullptr;
+      try {
+        parseMSA(family.alignmentFile, model->charmap(), sequences,
+                 patternWeights);
+      } catch (...) {
+      }
+      free(patternWeights);
+      if (sequences.size()) {
+        familyValues[2] = sequences[0]->len;
+        familyValues[3] = model->num_states();
+      }
+    }
+  }
+  ParallelContext::sumVectorUInt(values);
+  std::vector<FamilyCostFeatures> features;
+  for (unsigned int i = 0; i < familiesNumber; ++i) {
+    auto *familyValues = &values[i * featuresNumber];
+    features.push_back(FamilyCostFeatures(familyValues[0], familyValues[1],
+                                          familyValues[2], familyValues[3]));
+  }
+  return features;
+}
+
 void LibpllParsers::fillLeavesFromUtree(
     corax_utree_t *utree, std::unordered_set<std::string> &leaves) {
   for (unsigned int i = 0; i < utree->tip_count + utree->inner_count; ++i) {
@@ -345,13 +397,18 @@ void LibpllParsers::parsePhylip(const char *phylipFile,
 
 std::unique_ptr<Model>
 LibpllParsers::getModel(const std::string &modelStrOrFilename) {
+  return std::make_unique<Model>(getModelStr(modelStrOrFilename));
+}
+
+std::string
+LibpllParsers::getModelStr(const std::string &modelStrOrFilename) {
   std::string modelStr = modelStrOrFilename;
   std::ifstream f(modelStr);
   if (f.good()) {
     getline(f, modelStr);
     modelStr = modelStr.substr(0, modelStr.find(","));
   }
-  return std::make_unique<Model>(modelStr);
+  return modelStr;
 }
 
 bool LibpllParsers::fillLabelsFromAlignment(
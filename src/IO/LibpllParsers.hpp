@@ -2,6 +2,7 @@
 
 #include <IO/FamiliesFileParser.hpp>
 #include <IO/Model.hpp>
+#include <parallelization/CostModel.hpp>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -67,6 +68,13 @@ public:
 
   static std::vector<unsigned int>
   parallelGetTreeSizes(const Families &families);
+  /**
+   *  Cost model features of each family, in the order of families.
+   *  Alignment patterns and model states are only filled if
+   *  withAlignments is set, because it requires parsing the MSAs.
+   */
+  static std::vector<FamilyCostFeatures>
+  parallelGetCostFeatures(const Families &families, bool withAlignments);
   static void saveUtree(const corax_unode_t *utree, const std::string &fileName,
                         bool append = false);
   static void saveRtree(const corax_rnode_t *rtree,
@@ -76,6 +84,11 @@ public:
   static void getRtreeHierarchicalString(const corax_rtree_t *rtree,
                                          std::string &newick);
   static std::unique_ptr<Model> getModel(const std::string &modelStrOrFilename);
+  /**
+   *  Return the model string, reading it from the file
+   *  modelStrOrFilename if it exists
+   */
+  static std::string getModelStr(const std::string &modelStrOrFilename);
   static void writeSuperMatrixFasta(const SuperMatrix &superMatrix,
                                     const std::string &outputFile);
 
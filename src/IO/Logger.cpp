@@ -10,6 +10,7 @@ std::ofstream *Logger::logFile = nullptr;
 std::ofstream *Logger::rankLogFile = nullptr;
 std::ofstream *Logger::saveLogFile = nullptr;
 bool Logger::inited = false;
+bool Logger::contextSilent = false;
 
 Logger::Logger() : _os(&std::cout), _silent(true) { setType(lt_info); }
 
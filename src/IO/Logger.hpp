@@ -38,6 +38,11 @@ public:
   static void mute() { info._silent = true; }
   static void unmute() { info._silent = false; }
 
+  // if set, even the master rank of the current parallel context
+  // can't write info and timed logs (e.g. in all the groups of
+  // ParallelContext::pushGroupContext but one)
+  static void setContextSilent(bool silent) { contextSilent = silent; }
+
   // if true, the MPI rank can't write logs
   bool isSilent() {
     if (!_silent) {
@@ -47,7 +52,7 @@ public:
       return false;
     }
     return (_type == lt_timed || _type == lt_info) &&
-           ParallelContext::getRank();
+           (ParallelContext::getRank() || contextSilent);
   }
 
   static void enableLogFile(bool enable) { logFile = enable ? saveLogFile : 0; }
@@ -127,4 +132,5 @@ public:
   static std::ofstream *rankLogFile;
   static std::ofstream *saveLogFile;
   static bool inited;
+  static bool contextSilent;
 };
@@ -2,6 +2,13 @@
 #include <ctype.h>
 #include <iostream>
 #include <stdlib.h>
+#include <string>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // a separator is a character that ends a label
 int is_separator[256] = {
@@ -51,8 +58,9 @@ const char *error_type_diagnostic[PET_LAST] = {
     "File does not exist",
     "The newick string contains too few left or right parentheses, or a "
     "semicolon was inserted too early.",
-    "A node label is invalid or was set twice. Please also check the presence "
-    "of invalid characters, like ()[]'\";,: newlines spaces, tabs and "
+    "A node label is invalid or was set twice, or a comment or a quoted label "
+    "is not terminated. Please also check the presence of invalid characters "
+    "in unquoted labels, like ()[]'\";,: newlines spaces, tabs and "
     "unprintable characters like \x01",
     "The newick string should end with a semicolon",
     "The branch length of a node was set twice",
@@ -80,15 +88,46 @@ int is_numeric(char *s, double *d) {
   return *p == '\0';
 }
 
-void skip_spaces(char **buffer) {
-  while (to_trim[(int)**buffer]) {
+int is_numeric_range(const char *s, unsigned int size, double *d) {
+  // copy to a NUL-terminated buffer, because strtod could read
+  // after the end of the token (and of the mapped memory)
+  char small[64];
+  if (size < sizeof(small)) {
+    memcpy(small, s, size);
+    small[size] = '\0';
+    return is_numeric(small, d);
+  }
+  std::string large(s, size);
+  return is_numeric(&large[0], d);
+}
+
+void skip_spaces(const char **buffer, const char *end) {
+  while (*buffer != end && to_trim[(unsigned char)**buffer]) {
     (*buffer)++;
   }
 }
 
-unsigned int get_token_size(char *buffer) {
-  char *curr = buffer;
-  while (!is_separator[(int)*curr]) {
+int skip_delimited(const char **buffer, const char *end) {
+  char closing = (**buffer == '[') ? ']' : **buffer;
+  const char *curr = *buffer + 1;
+  while (curr != end) {
+    if (*curr == closing) {
+      if (closing == ']' || curr + 1 == end || curr[1] != closing) {
+        *buffer = curr + 1;
+        return 1;
+      }
+      // escaped quote
+      curr++;
+    }
+    curr++;
+  }
+  *buffer = end;
+  return 0;
+}
+
+unsigned int get_token_size(const char *buffer, const char *end) {
+  const char *curr = buffer;
+  while (curr != end && !is_separator[(unsigned char)*curr]) {
     curr++;
   }
   return curr - buffer;
@@ -113,10 +152,84 @@ char *get_file_content(const char *filename) {
   return buffer;
 }
 
-unsigned int read_token(char **buffer, Token *token) {
-  skip_spaces(buffer);
-  if (**buffer == '\0') {
+int map_file_content(const char *filename, FileContent *content) {
+  content->data = NULL;
+  content->size = 0;
+  content->mapped = false;
+#if defined(_WIN32)
+  char *buffer = get_file_content(filename);
+  if (!buffer) {
     return 0;
+  }
+  content->data = buffer;
+  content->size = strlen(buffer);
+  return 1;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return 0;
+  }
+  content->size = static_cast<size_t>(st.st_size);
+  if (content->size) {
+    void *data = mmap(NULL, content->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return 0;
+    }
+    // trees are read once, from the beginning to the end
+    madvise(data, content->size, MADV_SEQUENTIAL);
+    content->data = static_cast<const char *>(data);
+    content->mapped = true;
+  }
+  close(fd);
+  return 1;
+#endif
+}
+
+void unmap_file_content(FileContent *content) {
+#if !defined(_WIN32)
+  if (content->mapped) {
+    munmap(const_cast<char *>(content->data), content->size);
+  } else {
+    free(const_cast<char *>(content->data));
+  }
+#else
+  free(const_cast<char *>(content->data));
+#endif
+  content->data = NULL;
+  content->size = 0;
+  content->mapped = false;
+}
+
+unsigned int read_token(const char **buffer, const char *end, Token *token) {
+  skip_spaces(buffer, end);
+  token->str = NULL;
+  token->str_size = 0;
+  token->quote = 0;
+  while (*buffer != end && **buffer == '[') {
+    if (!skip_delimited(buffer, end)) {
+      token->type = TT_INVALID;
+      return 1;
+    }
+    skip_spaces(buffer, end);
+  }
+  if (*buffer == end || **buffer == '\0') {
+    return 0;
+  } else if (**buffer == '\'' || **buffer == '"') {
+    const char *begin = *buffer;
+    if (!skip_delimited(buffer, end)) {
+      token->type = TT_INVALID;
+      return 1;
+    }
+    token->type = TT_STRING;
+    token->quote = *begin;
+    token->str = begin + 1;
+    token->str_size = *buffer - begin - 2;
   } else if (**buffer == '(') {
     token->type = TT_LEFT_PAR;
     (*buffer)++;
@@ -133,18 +246,14 @@ unsigned int read_token(char **buffer, Token *token) {
     token->type = TT_SEMICOLON;
     (*buffer)++;
   } else {
-    unsigned int string_size = get_token_size(*buffer);
-    token->str = (char *)malloc(string_size + 1);
-    memcpy(token->str, *buffer, string_size);
-    token->str[string_size] = '\0';
-    token->type =
-        is_numeric(token->str, &token->numeric_value) ? TT_DOUBLE : TT_STRING;
+    unsigned int string_size = get_token_size(*buffer, end);
+    token->str = *buffer;
+    token->str_size = string_size;
+    token->type = is_numeric_range(token->str, string_size,
+                                   &token->numeric_value)
+                      ? TT_DOUBLE
+                      : TT_STRING;
     *buffer += string_size;
   }
   return 1;
 }
-
-void destroy_token(Token *token) {
-  free(token->str);
-  token->str = NULL;
-}
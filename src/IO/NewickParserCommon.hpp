@@ -47,18 +47,32 @@ struct ParsingError {
 
 int is_numeric(char *s, double *d);
 
+/**
+ *  Same as is_numeric, but s does not need to be
+ *  NUL-terminated and only its first size characters are read
+ */
+int is_numeric_range(const char *s, unsigned int size, double *d);
+
 /**
  *  Increment buffer until next character is not
- *  a space or tab
+ *  a space or tab (or until end is reached)
+ */
+void skip_spaces(const char **buffer, const char *end);
+
+/**
+ *  Increment buffer past the comment ([...]) or the quoted label
+ *  ('...' or "...", where a doubled quote stands for the quote
+ *  itself) starting at *buffer.
+ *  Returns 0 if it is not terminated before end
  */
-void skip_spaces(char **buffer);
+int skip_delimited(const char **buffer, const char *end);
 
 /**
  *  Return the size of the next token to read
  *  (number of characters before the next separator
- *  after the current character)
+ *  after the current character, or before end)
  */
-unsigned int get_token_size(char *buffer);
+unsigned int get_token_size(const char *buffer, const char *end);
 
 /**
  *  Reads and return the content of a file.
@@ -66,6 +80,30 @@ unsigned int get_token_size(char *buffer);
  */
 char *get_file_content(const char *filename);
 
+/**
+ *  Read-only view on the content of a file. On POSIX systems,
+ *  the file is memory-mapped instead of being copied.
+ *  The content is NOT NUL-terminated.
+ */
+struct FileContent {
+  const char *data;
+  size_t size;
+  // true if data was mapped with mmap, false if it was allocated
+  bool mapped;
+};
+
+/**
+ *  Map the content of filename into content.
+ *  Returns 0 if the file could not be opened.
+ *  The content has to be released with unmap_file_content
+ */
+int map_file_content(const char *filename, FileContent *content);
+
+/**
+ *  Release a content filled by map_file_content
+ */
+void unmap_file_content(FileContent *content);
+
 enum TokenType {
   TT_LEFT_PAR,
   TT_RIGHT_PAR,
@@ -73,29 +111,34 @@ enum TokenType {
   TT_COLON,
   TT_SEMICOLON,
   TT_DOUBLE,
-  TT_STRING
+  TT_STRING,
+  // unterminated comment or quoted label
+  TT_INVALID
 };
 
+/**
+ *  A token is a view on the parsed buffer: it does not
+ *  own any memory and does not need to be destroyed
+ */
 struct Token {
   // type of token (string, float, special character etc.)
   TokenType type;
-  // value of the token (only relevant for string and float tokens)
-  char *str;
+  // first character of the token in the parsed buffer (only relevant
+  // for string and float tokens). Not NUL-terminated
+  const char *str;
   // size of str
   unsigned int str_size;
+  // quote character of a quoted string token (str then excludes the
+  // quotes, and doubled quotes are not unescaped), 0 otherwise
+  char quote;
   // floating value of the token (only relevant for float tokens)
   double numeric_value;
 };
 
 /**
- *  Fill token with the next token in buffer,
- *  and increment the buffer pointer to the next pointer
- *  The token should then be destroyed with destroy_token
- */
-unsigned int read_token(char **buffer, Token *token);
-
-/**
- *  Deallocate the elements of token created
- *  with read_token
+ *  Fill token with the next token in [*buffer, end),
+ *  and increment the buffer pointer to the next pointer.
+ *  Comments are skipped.
+ *  Returns 0 if there is no token left
  */
-void destroy_token(Token *token);
+unsigned int read_token(const char **buffer, const char *end, Token *token);
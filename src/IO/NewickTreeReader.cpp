@@ -0,0 +1,95 @@
+#include "NewickTreeReader.hpp"
+
+#include <IO/LibpllException.hpp>
+#include <IO/RootedNewickParser.hpp>
+#include <cstring>
+
+static const char *skipLine(const char *current, const char *end) {
+  const char *newLine =
+      static_cast<const char *>(memchr(current, '\n', end - current));
+  return newLine ? newLine + 1 : end;
+}
+
+NewickTreeReader::NewickTreeReader(const std::string &filename,
+                                   bool acceptALE)
+    : _filename(filename), _firstTree(nullptr), _current(nullptr),
+      _contentEnd(nullptr),
+      _treeBegin(nullptr), _treeEnd(nullptr),
+      _treeIndex(static_cast<unsigned int>(-1)) {
+  if (!map_file_content(filename.c_str(), &_content)) {
+    throw LibpllException("Can't open file: ", filename);
+  }
+  _current = _content.data;
+  _contentEnd = _content.data + _content.size;
+  if (acceptALE && _content.size && _content.data[0] == '#') {
+    // .ale file: the newick string is the second line
+    _current = skipLine(_current, _contentEnd);
+    _contentEnd = skipLine(_current, _contentEnd);
+  }
+  _firstTree = _current;
+}
+
+NewickTreeReader::~NewickTreeReader() { unmap_file_content(&_content); }
+
+bool NewickTreeReader::next() {
+  skip_spaces(&_current, _contentEnd);
+  if (_current == _contentEnd) {
+    return false;
+  }
+  _treeBegin = _current;
+  // a tree ends with a semicolon, or at the end of the line
+  // if the semicolon is missing (the parser will then complain).
+  // Semicolons and newlines in comments and quoted labels are skipped
+  while (_current != _contentEnd && *_current != ';' && *_current != '\n') {
+    if (*_current == '[' || *_current == '\'' || *_current == '"') {
+      skip_delimited(&_current, _contentEnd);
+    } else {
+      ++_current;
+    }
+  }
+  if (_current != _contentEnd && *_current == ';') {
+    ++_current;
+  }
+  _treeEnd = _current;
+  _treeIndex++;
+  return true;
+}
+
+void NewickTreeReader::rewind() {
+  _current = _firstTree;
+  _treeBegin = _treeEnd = nullptr;
+  _treeIndex = static_cast<unsigned int>(-1);
+}
+
+corax_rtree_t *NewickTreeReader::parseRooted() const {
+  ParsingError error;
+  auto tree = custom_rtree_parse_newick_range(_treeBegin, _treeEnd, &error);
+  if (!tree) {
+    _throwParsingError(error);
+  }
+  return tree;
+}
+
+corax_utree_t *NewickTreeReader::parseUnrooted() const {
+  ParsingError error;
+  auto tree = custom_utree_parse_newick_range(_treeBegin, _treeEnd, &error);
+  if (!tree) {
+    _throwParsingError(error);
+  }
+  return tree;
+}
+
+void NewickTreeReader::_throwParsingError(const ParsingError &error) const {
+  std::string errorMessage = "Error while reading tree number ";
+  errorMessage += std::to_string(_treeIndex + 1) + " from file ";
+  errorMessage += _filename + ".\n";
+  errorMessage += "Error name: ";
+  errorMessage += std::string(get_parsing_error_name(error.type));
+  errorMessage += ".\n";
+  errorMessage += "Error help message: ";
+  errorMessage += std::string(get_parsing_error_diagnostic(error.type));
+  errorMessage += ".\n";
+  errorMessage += "The parsing error was detected at character ";
+  errorMessage += std::to_string(error.offset) + " of the tree.";
+  throw LibpllException(errorMessage);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <IO/NewickParserCommon.hpp>
+#include <string>
+
+/**
+ *  Iterate over the newick trees stored in a file without
+ *  copying them: the file is memory-mapped, and each tree is
+ *  parsed in place. Trees are separated with semicolons (usually
+ *  one tree per line).
+ *
+ *  Usage:
+ *    NewickTreeReader reader(filename);
+ *    while (reader.next()) {
+ *      PLLUnrootedTree tree(reader.parseUnrooted());
+ *    }
+ */
+class NewickTreeReader {
+public:
+  /**
+   *  @param filename the file to read
+   *  @param acceptALE if set and if the file is a .ale file
+   *  (starting with '#'), only read the newick string from
+   *  its second line
+   */
+  NewickTreeReader(const std::string &filename, bool acceptALE = false);
+  ~NewickTreeReader();
+
+  NewickTreeReader(const NewickTreeReader &) = delete;
+  NewickTreeReader &operator=(const NewickTreeReader &) = delete;
+  NewickTreeReader(NewickTreeReader &&) = delete;
+  NewickTreeReader &operator=(NewickTreeReader &&) = delete;
+
+  /**
+   *  Move to the next tree. Returns false if there is no tree left
+   */
+  bool next();
+
+  /**
+   *  Go back to the first tree (next() must then be called
+   *  to access it)
+   */
+  void rewind();
+
+  /**
+   *  Range of the current newick string (semicolon included)
+   */
+  const char *begin() const { return _treeBegin; }
+  const char *end() const { return _treeEnd; }
+
+  /**
+   *  Copy of the current newick string
+   */
+  std::string getString() const { return std::string(_treeBegin, _treeEnd); }
+
+  /**
+   *  Index of the current tree in the file
+   */
+  unsigned int getTreeIndex() const { return _treeIndex; }
+
+  /**
+   *  Parse the current tree. The caller is responsible for
+   *  destroying it. Throws a LibpllException if the parsing fails
+   */
+  corax_rtree_t *parseRooted() const;
+  corax_utree_t *parseUnrooted() const;
+
+private:
+  std::string _filename;
+  FileContent _content;
+  const char *_firstTree;
+  const char *_current;
+  const char *_contentEnd;
+  const char *_treeBegin;
+  const char *_treeEnd;
+  unsigned int _treeIndex;
+  void _throwParsingError(const ParsingError &error) const;
+};
@@ -0,0 +1,117 @@
+#include "PerFamilyLikelihoodStream.hpp"
+
+#include <IO/LibpllException.hpp>
+#include <cassert>
+#include <cstdio>
+#include <parallelization/ParallelContext.hpp>
+
+PerFamilyLikelihoodStream::PerFamilyLikelihoodStream(
+    unsigned int localFamilies, const std::string &treesOutput,
+    const std::string &llOutput)
+    : _llOutput(llOutput), _binaryFile(llOutput + ".bin"),
+      _localFamilies(localFamilies), _totalFamilies(0), _familyOffset(0),
+      _trees(0), _writeError(false) {
+  std::vector<unsigned int> perRankFamilies;
+  ParallelContext::allGatherUInt(localFamilies, perRankFamilies);
+  for (unsigned int i = 0; i < perRankFamilies.size(); ++i) {
+    if (i < ParallelContext::getRank()) {
+      _familyOffset += perRankFamilies[i];
+    }
+    _totalFamilies += perRankFamilies[i];
+  }
+  bool created = true;
+  if (!ParallelContext::getRank()) {
+    _treesOs.open(treesOutput);
+    // create (or truncate) the shared binary file
+    std::ofstream os(_binaryFile, std::ios::binary | std::ios::trunc);
+    created = _treesOs && os;
+  }
+  // the errors are collective, such that all ranks throw together.
+  // This also waits for the master to create the binary file
+  ParallelContext::parallelAnd(created);
+  if (!created) {
+    removeBinaryFile();
+    throw LibpllException("Cannot create ", _binaryFile);
+  }
+  _binary.open(_binaryFile, std::ios::binary | std::ios::in | std::ios::out);
+  bool opened = !!_binary;
+  ParallelContext::parallelAnd(opened);
+  if (!opened) {
+    removeBinaryFile();
+    throw LibpllException("Cannot open ", _binaryFile);
+  }
+}
+
+PerFamilyLikelihoodStream::~PerFamilyLikelihoodStream() {
+  _binary.close();
+  removeBinaryFile();
+}
+
+void PerFamilyLikelihoodStream::removeBinaryFile() {
+  if (!ParallelContext::getRank()) {
+    std::remove(_binaryFile.c_str());
+  }
+}
+
+void PerFamilyLikelihoodStream::addTree(
+    const std::string &newick, const std::vector<double> &localPerFamLL) {
+  assert(localPerFamLL.size() == _localFamilies);
+  if (_writeError) {
+    return;
+  }
+  if (!ParallelContext::getRank()) {
+    _treesOs << newick << std::endl;
+    _writeError = !_treesOs;
+  }
+  auto offset =
+      (static_cast<std::streamoff>(_trees) * _totalFamilies + _familyOffset) *
+      sizeof(double);
+  _binary.seekp(offset);
+  _binary.write(reinterpret_cast<const char *>(localPerFamLL.data()),
+                _localFamilies * sizeof(double));
+  _writeError = _writeError || !_binary;
+  _trees++;
+}
+
+void PerFamilyLikelihoodStream::finalize() {
+  _binary.close();
+  bool written = !_writeError && !_binary.fail();
+  if (!ParallelContext::getRank()) {
+    _treesOs.close();
+    written = written && !_treesOs.fail();
+  }
+  // also waits for all ranks to write their likelihoods
+  ParallelContext::parallelAnd(written);
+  if (!written) {
+    throw LibpllException("Cannot write to ", _binaryFile);
+  }
+  bool converted = true;
+  if (!ParallelContext::getRank()) {
+    std::ifstream is(_binaryFile, std::ios::binary);
+    std::ofstream osLL(_llOutput);
+    osLL << _trees << " " << _totalFamilies << std::endl;
+    std::vector<double> perFamLL(_totalFamilies);
+    for (unsigned int i = 0; i < _trees && converted; ++i) {
+      is.read(reinterpret_cast<char *>(perFamLL.data()),
+              _totalFamilies * sizeof(double));
+      if (!is) {
+        converted = false;
+        break;
+      }
+      osLL << "tree" << (i + 1);
+      for (auto ll : perFamLL) {
+        osLL << " " << ll;
+      }
+      osLL << std::endl;
+      converted = !!osLL;
+    }
+    is.close();
+    osLL.close();
+    converted = converted && !osLL.fail();
+  }
+  removeBinaryFile();
+  ParallelContext::parallelAnd(converted);
+  if (!converted) {
+    throw LibpllException("Cannot convert the likelihoods to ", _llOutput);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ *  Streams the per-family likelihoods of a sequence of trees to the
+ *  CONSEL input files, without gathering them on the master rank.
+ *
+ *  Each rank writes its local per-family likelihoods into a shared
+ *  binary file at precomputed offsets (trees x families doubles,
+ *  families ordered by rank). finalize converts this file into the
+ *  CONSEL format one tree at a time, such that no rank ever holds
+ *  more than the likelihoods of a single tree.
+ *
+ *  All methods must be called by all ranks in the same order.
+ *  Write errors are only reported (collectively) by finalize.
+ */
+class PerFamilyLikelihoodStream {
+public:
+  /**
+   *  localFamilies: number of families handled by this rank
+   *  treesOutput: file that will contain the list of trees
+   *  llOutput: file that will contain the CONSEL likelihoods
+   */
+  PerFamilyLikelihoodStream(unsigned int localFamilies,
+                            const std::string &treesOutput,
+                            const std::string &llOutput);
+
+  /**
+   *  Remove the binary file if finalize did not
+   */
+  ~PerFamilyLikelihoodStream();
+
+  PerFamilyLikelihoodStream(const PerFamilyLikelihoodStream &) = delete;
+  PerFamilyLikelihoodStream &
+  operator=(const PerFamilyLikelihoodStream &) = delete;
+
+  /**
+   *  Append a tree and the likelihoods of the local families.
+   *  A failure is recorded locally, such that the other ranks
+   *  do not wait forever for this one, and thrown by finalize.
+   */
+  void addTree(const std::string &newick,
+               const std::vector<double> &localPerFamLL);
+
+  /**
+   *  Write the CONSEL likelihood file and remove the binary file.
+   *  Throws on all ranks if any rank failed to write.
+   */
+  void finalize();
+
+private:
+  void removeBinaryFile();
+
+  std::string _llOutput;
+  std::string _binaryFile;
+  unsigned int _localFamilies;
+  unsigned int _totalFamilies;
+  // index of the first local family in the global family order
+  unsigned int _familyOffset;
+  unsigned int _trees;
+  bool _writeError;
+  std::fstream _binary;
+  std::ofstream _treesOs;
+};
@@ -5,11 +5,11 @@
  */
 struct RTreeParser {
   // Pointer to the start of the newick string
-  char *input;
+  const char *input;
   // Pointer to the current offset in the newick string
-  char *input_current;
-  // size of input
-  unsigned int input_size;
+  const char *input_current;
+  // Pointer to the end of the newick string
+  const char *input_end;
   // buffer containing all nodes
   corax_rnode_t **nodes;
   // allocated size of nodes
@@ -20,8 +20,11 @@ struct RTreeParser {
   corax_rnode_t *current_node;
   // parent of current_node
   corax_rnode_t *parent_node;
-  // are we reading from a file or from a string
-  bool is_file;
+  // if set, the top node can have three children, and we
+  // insert an extra node under the root to get a binary tree
+  bool allow_unrooted;
+  // node inserted under the root for unrooted trees (if any)
+  corax_rnode_t *unrooted_node;
   // object to fill if parsing fails
   ParsingError *error;
 };
@@ -37,9 +40,6 @@ void destroy_rtree_parser(struct RTreeParser *p) {
     free(p->nodes[i]);
   }
   free(p->nodes);
-  if (p->is_file) {
-    free(p->input);
-  }
 }
 
 /**
@@ -57,8 +57,23 @@ void set_error(struct RTreeParser *p, ParsingErrorType type) {
   }
 }
 
+/**
+ *  Return the number of nodes of the first tree in [input, end),
+ *  such that the node buffer can be allocated once.
+ *  Each left parenthesis and each comma creates a new node
+ *  (plus one node for the root)
+ */
+unsigned int count_rtree_nodes(const char *input, const char *end) {
+  unsigned int count = 1;
+  for (const char *c = input; c != end && *c != ';' && *c != '\0'; ++c) {
+    count += (*c == '(' || *c == ',');
+  }
+  return count;
+}
+
 /**
  *  Allocate a larger node buffer in p
+ *  (only needed if the first pass count was wrong)
  */
 void increase_nodes_capacity(RTreeParser *p) {
   p->nodes_capacity *= 4;
@@ -92,14 +107,41 @@ corax_rnode_t *rtree_parse_add_node(RTreeParser *p) {
     } else if (!parent_node->right) {
       parent_node->right = node;
     } else {
-      if (parent_node->parent == NULL) {
-        set_error(p, PET_UNROOTED);
+      if (parent_node->parent == NULL && p->allow_unrooted &&
+          !p->unrooted_node) {
+        // third child of the top node: we move the second child
+        // and the new node under an extra node, with a null branch length
+        corax_rnode_t *unrooted_node =
+            (corax_rnode_t *)malloc(sizeof(corax_rnode_t));
+        unrooted_node->label = NULL;
+        unrooted_node->length = 0.0;
+        unrooted_node->data = NULL;
+        unrooted_node->parent = parent_node;
+        unrooted_node->left = parent_node->right;
+        unrooted_node->right = node;
+        unrooted_node->left->parent = unrooted_node;
+        parent_node->right = unrooted_node;
+        node->parent = unrooted_node;
+        p->unrooted_node = unrooted_node;
+        // the extra node takes the slot of node
+        p->nodes[p->nodes_number] = unrooted_node;
+        unrooted_node->node_index = p->nodes_number;
+        p->nodes_number++;
+        if (p->nodes_number >= p->nodes_capacity) {
+          increase_nodes_capacity(p);
+        }
+        p->nodes[p->nodes_number] = node;
+        node->node_index = p->nodes_number;
       } else {
-        set_error(p, PET_POLYTOMY);
+        if (parent_node->parent == NULL) {
+          set_error(p, PET_UNROOTED);
+        } else {
+          set_error(p, PET_POLYTOMY);
+        }
+        free(node);
+        p->nodes[p->nodes_number] = NULL;
+        return NULL;
       }
-      free(node);
-      p->nodes[p->nodes_number] = NULL;
-      return NULL;
     }
   }
   p->nodes_number++;
@@ -128,6 +170,10 @@ void rtree_go_up(RTreeParser *p) {
   }
   p->current_node = p->parent_node;
   p->parent_node = p->parent_node->parent;
+  if (p->parent_node && p->parent_node == p->unrooted_node) {
+    // the inserted node does not appear in the newick string
+    p->parent_node = p->parent_node->parent;
+  }
 }
 
 /**
@@ -150,8 +196,17 @@ void rtree_add_label(RTreeParser *p, Token *token) {
   if (is_branch_length_set(p->current_node)) {
     set_error(p, PET_INVALID_BRANCH_LENGTH);
   }
-  p->current_node->label = token->str;
-  token->str = NULL;
+  char *label = (char *)malloc(token->str_size + 1);
+  unsigned int size = 0;
+  for (unsigned int i = 0; i < token->str_size; ++i) {
+    label[size++] = token->str[i];
+    if (token->quote && token->str[i] == token->quote) {
+      // doubled quote in a quoted label
+      ++i;
+    }
+  }
+  label[size] = '\0';
+  p->current_node->label = label;
 }
 
 void terminate_node_creation(corax_rnode_t *node) {
@@ -166,26 +221,23 @@ void terminate_node_creation(corax_rnode_t *node) {
 void parse(RTreeParser *p) {
   Token token;
   Token tokenBL;
-  token.str = NULL;
-  tokenBL.str = NULL;
   bool end = false;
   rtree_add_node_down(p); // add root
 
-  while (!end && read_token(&p->input_current, &token)) {
+  while (!end && read_token(&p->input_current, p->input_end, &token)) {
     switch (token.type) {
     case TT_SEMICOLON:
       end = true;
       break;
     case TT_COLON:
-      read_token(&p->input_current, &tokenBL);
-      if (tokenBL.type != TT_DOUBLE) {
+      if (!read_token(&p->input_current, p->input_end, &tokenBL) ||
+          tokenBL.type != TT_DOUBLE) {
         set_error(p, PET_INVALID_BRANCH_LENGTH);
       }
       if (is_branch_length_set(p->current_node)) {
         set_error(p, PET_DOUBLE_BRANCH_LENGTH);
       }
       p->current_node->length = tokenBL.numeric_value;
-      destroy_token(&tokenBL);
       break;
     case TT_LEFT_PAR:
       // go down in the tree
@@ -209,8 +261,10 @@ void parse(RTreeParser *p) {
     case TT_DOUBLE:
       rtree_add_label(p, &token);
       break;
+    case TT_INVALID:
+      set_error(p, PET_INVALID_LABEL);
+      break;
     }
-    destroy_token(&token);
     end |= has_errored(p);
   }
   if (p->parent_node) {
@@ -220,9 +274,8 @@ void parse(RTreeParser *p) {
   if (!end) {
     set_error(p, PET_NOSEMICOLON);
   }
-  if (read_token(&p->input_current, &token)) {
+  if (read_token(&p->input_current, p->input_end, &token)) {
     set_error(p, PET_TOKEN_AFTER_SEMICOLON);
-    destroy_token(&token);
   }
   if (p->error->type == PET_NOERROR) {
     terminate_node_creation(p->current_node);
@@ -272,31 +325,67 @@ corax_rtree_t *build_rtree(RTreeParser *p) {
   return tree;
 }
 
-corax_rtree_t *custom_rtree_parse_newick(const char *input, bool is_file,
-                                         ParsingError *error) {
+static corax_rtree_t *parse_rtree_range(const char *begin, const char *end,
+                                        bool allow_unrooted,
+                                        ParsingError *error) {
   RTreeParser p;
   p.error = error;
   error->type = PET_NOERROR;
-  // todo: use const correctly!!
-  p.is_file = is_file;
-  if (is_file) {
-    p.input = get_file_content(input);
-    if (p.input == NULL) {
-      set_error(&p, PET_FILE_DOES_NOT_EXISTS);
-      return NULL;
-    }
-  } else {
-    p.input = (char *)input;
-  }
-  p.input_current = (char *)p.input;
-  p.nodes_capacity = 1000;
+  p.input = begin;
+  p.input_current = begin;
+  p.input_end = end;
+  // one extra node for the node inserted under unrooted roots
+  p.nodes_capacity = count_rtree_nodes(begin, end) + 1;
   p.nodes_number = 0;
   p.nodes = (corax_rnode_t **)calloc(p.nodes_capacity, sizeof(corax_rnode_t *));
   assert(p.nodes);
   p.current_node = NULL;
   p.parent_node = NULL;
+  p.allow_unrooted = allow_unrooted;
+  p.unrooted_node = NULL;
   parse(&p);
   corax_rtree_t *rtree = build_rtree(&p);
   destroy_rtree_parser(&p);
   return rtree;
 }
+
+corax_rtree_t *custom_rtree_parse_newick_range(const char *begin,
+                                               const char *end,
+                                               ParsingError *error) {
+  return parse_rtree_range(begin, end, false, error);
+}
+
+corax_utree_t *custom_utree_parse_newick_range(const char *begin,
+                                               const char *end,
+                                               ParsingError *error) {
+  corax_rtree_t *rtree = parse_rtree_range(begin, end, true, error);
+  if (!rtree) {
+    return NULL;
+  }
+  corax_utree_t *utree = corax_rtree_unroot(rtree);
+  corax_rtree_destroy(rtree, NULL);
+  if (utree) {
+    corax_unode_t *root =
+        utree->nodes[utree->tip_count + utree->inner_count - 1];
+    corax_utree_reset_template_indices(root, utree->tip_count);
+  }
+  return utree;
+}
+
+corax_rtree_t *custom_rtree_parse_newick(const char *input, bool is_file,
+                                         ParsingError *error) {
+  if (!is_file) {
+    return custom_rtree_parse_newick_range(input, input + strlen(input),
+                                           error);
+  }
+  FileContent content;
+  if (!map_file_content(input, &content)) {
+    error->type = PET_FILE_DOES_NOT_EXISTS;
+    error->offset = 0;
+    return NULL;
+  }
+  corax_rtree_t *rtree = custom_rtree_parse_newick_range(
+      content.data, content.data + content.size, error);
+  unmap_file_content(&content);
+  return rtree;
+}
@@ -10,3 +10,23 @@
  */
 corax_rtree_t *custom_rtree_parse_newick(const char *s, bool is_file,
                                          ParsingError *error);
+
+/**
+ *  Parse a rooted tree from the newick string stored in [begin, end),
+ *  without copying it. The string does not need to be NUL-terminated.
+ *  If an error occures, returns NULL and fills the
+ *  error object.
+ */
+corax_rtree_t *custom_rtree_parse_newick_range(const char *begin,
+                                               const char *end,
+                                               ParsingError *error);
+
+/**
+ *  Parse an unrooted tree from the newick string stored in [begin, end),
+ *  without copying it. The top node can have two or three children.
+ *  If an error occures, returns NULL and fills the
+ *  error object.
+ */
+corax_utree_t *custom_utree_parse_newick_range(const char *begin,
+                                               const char *end,
+                                               ParsingError *error);
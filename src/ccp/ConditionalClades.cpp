@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include <IO/Logger.hpp>
+#include <IO/NewickTreeReader.hpp>
 #include <trees/PLLRootedTree.hpp>
 #include <trees/PLLUnrootedTree.hpp>
 
@@ -15,11 +16,11 @@ struct TreeWraper {
   corax_unode_t *root;
   size_t hash;
   double ll;
-  TreeWraper(const std::string newickStr, bool rooted)
+  TreeWraper(const NewickTreeReader &reader, bool rooted)
       : rtree(nullptr), root(nullptr), ll(0.0) {
-    tree = std::make_shared<PLLUnrootedTree>(newickStr, false);
+    tree = std::make_shared<PLLUnrootedTree>(reader.parseUnrooted());
     if (rooted) {
-      rtree = std::make_shared<PLLRootedTree>(newickStr, false);
+      rtree = std::make_shared<PLLRootedTree>(reader.parseRooted());
       root = tree->getRoot(*rtree, true);
       hash = tree->getRootedTreeHash(root);
     } else {
@@ -90,36 +91,32 @@ static bool readTrees(const std::string &inputFile,
                       WeightedTrees &weightedTrees, unsigned int &inputTrees,
                       unsigned int &uniqueInputTrees,
                       unsigned int sampleFrequency) {
-  std::ifstream infile(inputFile);
   std::string line;
   bool useLikelihoods = likelihoodFile.size() != 0;
-  std::vector<std::string> lines;
   std::vector<double> likelihoods;
-  unsigned int index = 0;
-  while (std::getline(infile, line)) {
-    if (index % sampleFrequency == 0) {
-      lines.push_back(line);
-    }
-    index++;
-  }
   if (useLikelihoods) {
     std::ifstream llFile(likelihoodFile);
     while (std::getline(llFile, line)) {
       double ll = std::stod(line);
       likelihoods.push_back(ll);
     }
-    assert(likelihoods.size() == lines.size());
   }
 
+  // the trees are parsed in place, without copying the file lines
+  NewickTreeReader reader(inputFile);
   unsigned int llIndex = 0;
-  for (auto line : lines) {
-    TreeWraper wraper(line, rooted);
+  while (reader.next()) {
+    if (reader.getTreeIndex() % sampleFrequency != 0) {
+      continue;
+    }
+    TreeWraper wraper(reader, rooted);
     if (!wraper.tree->hasUniqueLeafLabels()) {
       Logger::error << "Error, the trees in " << inputFile
                     << " have duplicated leaf labels" << std::endl;
       return false;
     }
     if (useLikelihoods) {
+      assert(llIndex < likelihoods.size());
       wraper.ll = likelihoods[llIndex++];
     };
     auto it = weightedTrees.find(wraper);
@@ -137,6 +134,7 @@ static bool readTrees(const std::string &inputFile,
     }
     inputTrees++;
   }
+  assert(llIndex == likelihoods.size());
   uniqueInputTrees = weightedTrees.size();
   return true;
 }
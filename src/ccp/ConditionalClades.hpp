@@ -61,7 +61,9 @@ using CladeSplits = std::vector<CladeSplit>;
  */
 class ConditionalClades {
 public:
-  ConditionalClades() {}
+  ConditionalClades()
+      : _inputTrees(0), _uniqueInputTrees(0), _ccpRooting(CCPRooting::UNIFORM),
+        _isValid(true) {}
   ConditionalClades(const std::string &inputFile,
                     const std::string &likelihoods, CCPRooting ccpRooting,
                     unsigned int sampleFrequency = 1);
@@ -0,0 +1,79 @@
+#include "EvaluationMemoryManager.hpp"
+
+#include <cassert>
+#include <iterator>
+#include <likelihoods/ReconciliationEvaluation.hpp>
+
+EvaluationMemoryManager::EvaluationMemoryManager(size_t budget)
+    : _budget(budget), _usedMemory(0), _releases(0) {}
+
+unsigned int
+EvaluationMemoryManager::add(ReconciliationEvaluation *evaluation) {
+  Entry entry;
+  entry.evaluation = evaluation;
+  entry.footprint = 0;
+  entry.resident = false;
+  entry.recencyPosition = _recency.end();
+  _entries.push_back(entry);
+  return static_cast<unsigned int>(_entries.size() - 1);
+}
+
+void EvaluationMemoryManager::remove(unsigned int id) {
+  assert(id < _entries.size());
+  onRelease(id);
+  _entries[id].evaluation = nullptr;
+}
+
+void EvaluationMemoryManager::touch(unsigned int id, size_t footprint) {
+  assert(id < _entries.size() && _entries[id].evaluation);
+  auto &entry = _entries[id];
+  if (entry.resident && entry.recencyPosition == _recency.begin() &&
+      entry.footprint == footprint) {
+    // most frequent case: the same family is evaluated several times
+    return;
+  }
+  if (entry.resident) {
+    setReleased(id);
+  }
+  setResident(id, footprint);
+  // release the most recently used models first (scan resistance,
+  // see the class description), but never the model that is used
+  while (_usedMemory > _budget && _recency.size() > 1) {
+    // releaseModel calls onRelease
+    _entries[*std::next(_recency.begin())].evaluation->releaseModel();
+    _releases++;
+  }
+}
+
+void EvaluationMemoryManager::onRelease(unsigned int id) {
+  assert(id < _entries.size());
+  if (_entries[id].resident) {
+    setReleased(id);
+  }
+}
+
+std::shared_ptr<EvaluationMemoryManager>
+EvaluationMemoryManager::create(unsigned int budgetMB) {
+  if (!budgetMB) {
+    return nullptr;
+  }
+  return std::make_shared<EvaluationMemoryManager>(size_t(budgetMB) << 20);
+}
+
+void EvaluationMemoryManager::setResident(unsigned int id, size_t footprint) {
+  auto &entry = _entries[id];
+  entry.footprint = footprint;
+  entry.resident = true;
+  _usedMemory += footprint;
+  _recency.push_front(id);
+  entry.recencyPosition = _recency.begin();
+}
+
+void EvaluationMemoryManager::setReleased(unsigned int id) {
+  auto &entry = _entries[id];
+  assert(entry.resident);
+  _usedMemory -= entry.footprint;
+  _recency.erase(entry.recencyPosition);
+  entry.recencyPosition = _recency.end();
+  entry.resident = false;
+}
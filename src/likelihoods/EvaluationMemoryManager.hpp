@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <vector>
+
+class ReconciliationEvaluation;
+
+/**
+ *  Keeps the memory used by the reconciliation models (mostly CLVs)
+ *  of the local families within a per-rank budget.
+ *
+ *  Each evaluation notifies the manager when its model is used. When
+ *  the models exceed the budget, some of them are released: their
+ *  evaluation only keeps its compact state (gene tree or CCP, rates,
+ *  highways and root), and rebuilds the model the next time it is
+ *  evaluated.
+ *
+ *  The likelihood computations scan all the local families in the
+ *  same order, under which releasing the least recently used model
+ *  would release every model before its next use. We release the
+ *  most recently used models instead (except the one being used):
+ *  the first models of the scan stay resident, and the others take
+ *  turns in the remaining memory, such that each scan only rebuilds
+ *  the models that do not fit in the budget.
+ */
+class EvaluationMemoryManager {
+public:
+  /**
+   *  @param budget memory budget for the models, in bytes
+   */
+  explicit EvaluationMemoryManager(size_t budget);
+
+  /**
+   *  Register an evaluation, and return its id in the manager
+   */
+  unsigned int add(ReconciliationEvaluation *evaluation);
+  void remove(unsigned int id);
+
+  /**
+   *  Mark the model of an evaluation as the most recently used one,
+   *  and release the previously used models that do not fit in the
+   *  budget anymore
+   *  @param footprint current memory footprint of the model
+   */
+  void touch(unsigned int id, size_t footprint);
+
+  /**
+   *  Called when the model of an evaluation has been released
+   */
+  void onRelease(unsigned int id);
+
+  size_t getBudget() const { return _budget; }
+  size_t getUsedMemory() const { return _usedMemory; }
+  unsigned int getReleasesNumber() const { return _releases; }
+
+  /**
+   *  Create a manager with a budget in MB, or return null if the
+   *  budget is 0 (no limit)
+   */
+  static std::shared_ptr<EvaluationMemoryManager>
+  create(unsigned int budgetMB);
+
+private:
+  struct Entry {
+    ReconciliationEvaluation *evaluation;
+    size_t footprint;
+    bool resident;
+    std::list<unsigned int>::iterator recencyPosition;
+  };
+  size_t _budget;
+  size_t _usedMemory;
+  unsigned int _releases;
+  std::vector<Entry> _entries;
+  // resident models, from the most to the least recently used
+  std::list<unsigned int> _recency;
+
+  void setResident(unsigned int id, size_t footprint);
+  void setReleased(unsigned int id);
+};
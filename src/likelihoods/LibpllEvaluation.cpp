@@ -44,6 +44,13 @@ LibpllEvaluation::LibpllEvaluation(const std::string &newickStrOrFile,
     : _treeInfo(std::make_unique<PLLTreeInfo>(
           newickStrOrFile, isNewickAFile, alignmentFilename, modelStrOrFile)) {}
 
+LibpllEvaluation::LibpllEvaluation(const std::string &newickStrOrFile,
+                                   bool isNewickAFile,
+                                   const std::string &alignmentFilename,
+                                   const Model &model)
+    : _treeInfo(std::make_unique<PLLTreeInfo>(newickStrOrFile, isNewickAFile,
+                                              alignmentFilename, model)) {}
+
 double LibpllEvaluation::raxmlSPRRounds(unsigned int minRadius,
                                         unsigned int maxRadius,
                                         unsigned int thorough,
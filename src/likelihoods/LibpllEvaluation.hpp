@@ -44,6 +44,13 @@ public:
                    const std::string &alignmentFilename,
                    const std::string &modelStrOrFile);
 
+  /*
+   * Same as above, but copy an already parsed model, to avoid
+   * parsing the same model string for many families
+   */
+  LibpllEvaluation(const std::string &newickStrOrFile, bool isNewickAFile,
+                   const std::string &alignmentFilename, const Model &model);
+
   /*
    *  Compute the likelihood of the tree given the alignment
    *  @param incremental if true, only recompute invalid CLVs
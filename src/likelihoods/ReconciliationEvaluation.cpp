@@ -1,21 +1,152 @@
 #include "ReconciliationEvaluation.hpp"
 
 #include <likelihoods/reconciliation_models/ParsimonyDModel.hpp>
+#include <likelihoods/reconciliation_models/PolytomyDTLModel.hpp>
+#include <IO/LibpllException.hpp>
+#include <likelihoods/EvaluationMemoryManager.hpp>
 #include <likelihoods/reconciliation_models/SimpleDSModel.hpp>
 #include <likelihoods/reconciliation_models/UndatedDLModel.hpp>
+#include <likelihoods/reconciliation_models/UndatedDLMultiModel.hpp>
 #include <likelihoods/reconciliation_models/UndatedDTLModel.hpp>
+#include <likelihoods/reconciliation_models/UndatedDTLMultiModel.hpp>
 
 ReconciliationEvaluation::ReconciliationEvaluation(
     PLLRootedTree &speciesTree, PLLUnrootedTree &initialGeneTree,
     const GeneSpeciesMapping &geneSpeciesMapping,
     const RecModelInfo &recModelInfo, const std::string &forcedRootedGeneTree)
-    : _speciesTree(speciesTree), _initialGeneTree(initialGeneTree),
+    : _speciesTree(speciesTree), _initialGeneTree(&initialGeneTree),
       _geneSpeciesMapping(geneSpeciesMapping), _recModelInfo(recModelInfo),
-      _infinitePrecision(true), _forcedRootedGeneTree(forcedRootedGeneTree) {
+      _infinitePrecision(true),
+      _integratePolytomies(recModelInfo.integratePolytomies),
+      _multiModel(nullptr), _forcedRootedGeneTree(forcedRootedGeneTree),
+      _partialLikelihoodMode(PartialLikelihoodMode::PartialGenes),
+      _releasedRoot(nullptr), _memoryId(0) {
+  if (_integratePolytomies &&
+      (recModelInfo.model != RecModel::UndatedDTL ||
+       recModelInfo.transferConstraint == TransferConstaint::RELDATED ||
+       recModelInfo.branchLengthThreshold < 0.0)) {
+    throw LibpllException("Polytomy integration requires the UndatedDTL "
+                          "model without the RELDATED transfer constraint, "
+                          "and a non-negative branch length threshold");
+  }
   _evaluators = buildRecModelObject(_recModelInfo.model, _infinitePrecision);
 }
 
-ReconciliationEvaluation::~ReconciliationEvaluation() { delete _evaluators; }
+ReconciliationEvaluation::ReconciliationEvaluation(
+    PLLRootedTree &speciesTree, std::shared_ptr<const ConditionalClades> ccp,
+    const GeneSpeciesMapping &geneSpeciesMapping,
+    const RecModelInfo &recModelInfo)
+    : _speciesTree(speciesTree), _initialGeneTree(nullptr),
+      _geneSpeciesMapping(geneSpeciesMapping), _recModelInfo(recModelInfo),
+      _infinitePrecision(true), _integratePolytomies(false),
+      _evaluators(nullptr), _multiModel(nullptr),
+      _ccp(std::move(ccp)),
+      _partialLikelihoodMode(PartialLikelihoodMode::PartialGenes),
+      _releasedRoot(nullptr), _memoryId(0) {
+  _multiModel = buildMultiModelObject();
+}
+
+ReconciliationEvaluation::~ReconciliationEvaluation() {
+  if (_memoryManager) {
+    _memoryManager->remove(_memoryId);
+  }
+  delete _evaluators;
+  delete _multiModel;
+}
+
+MultiModelInterface *ReconciliationEvaluation::buildMultiModelObject() {
+  switch (_recModelInfo.model) {
+  case RecModel::UndatedDL:
+    return new UndatedDLMultiModel<ScaledValue>(
+        _speciesTree, _geneSpeciesMapping, _recModelInfo, *_ccp);
+  case RecModel::UndatedDTL:
+    return new UndatedDTLMultiModel<ScaledValue>(
+        _speciesTree, _geneSpeciesMapping, _recModelInfo, *_ccp);
+  default:
+    throw LibpllException("Unsupported reconciliation model with "
+                          "conditional clade probabilities: ",
+                          ArgumentsHelper::recModelToStr(_recModelInfo.model));
+  }
+}
+
+void ReconciliationEvaluation::setMemoryManager(
+    std::shared_ptr<EvaluationMemoryManager> manager) {
+  assert(!_memoryManager);
+  _memoryManager = manager;
+  if (_memoryManager) {
+    _memoryId = _memoryManager->add(this);
+    if (!isModelReleased()) {
+      _memoryManager->touch(_memoryId, getModelMemoryFootprint());
+    }
+  }
+}
+
+void ReconciliationEvaluation::releaseModel() {
+  if (_memoryManager) {
+    _memoryManager->onRelease(_memoryId);
+  }
+  if (_evaluators) {
+    _releasedRoot = _evaluators->getRoot();
+  }
+  delete _evaluators;
+  delete _multiModel;
+  _evaluators = nullptr;
+  _multiModel = nullptr;
+}
+
+size_t ReconciliationEvaluation::getModelMemoryFootprint() const {
+  // rough estimate, dominated by the CLVs: one value per species node
+  // and per directed gene node (or clade), and about twice more for
+  // the DTL models that also store per-species transfer sums
+  size_t genes = 0;
+  size_t valueSize = sizeof(ScaledValue);
+  if (isAmalgamated()) {
+    genes = _ccp->getCladesNumber();
+  } else {
+    genes = _initialGeneTree->getDirectedNodeNumber();
+    if (!_infinitePrecision) {
+      valueSize = sizeof(double);
+    }
+  }
+  size_t vectors = Enums::accountsForTransfers(_recModelInfo.model) ? 2 : 1;
+  return genes * _speciesTree.getNodeNumber() * valueSize * vectors;
+}
+
+void ReconciliationEvaluation::useModel() {
+  if (isModelReleased()) {
+    rebuildModel();
+  }
+  if (_memoryManager) {
+    _memoryManager->touch(_memoryId, getModelMemoryFootprint());
+  }
+}
+
+void ReconciliationEvaluation::rebuildModel() {
+  assert(isModelReleased());
+  if (isAmalgamated()) {
+    _multiModel = buildMultiModelObject();
+  } else {
+    _evaluators = buildRecModelObject(_recModelInfo.model, _infinitePrecision);
+    _evaluators->setPartialLikelihoodMode(_partialLikelihoodMode);
+  }
+  if (_highways.size()) {
+    getModel().setHighways(_highways);
+  }
+  if (_rates.size()) {
+    getModel().setRates(_rates);
+  }
+  if (_releasedRoot) {
+    _evaluators->setRoot(_releasedRoot);
+    _releasedRoot = nullptr;
+  }
+}
+
+BaseReconciliationModel &ReconciliationEvaluation::getModel() {
+  if (_multiModel) {
+    return *_multiModel;
+  }
+  return *_evaluators;
+}
 
 void ReconciliationEvaluation::setRates(const Parameters &parameters) {
   unsigned int freeParameters = Enums::freeParameters(_recModelInfo.model);
@@ -35,31 +166,62 @@ void ReconciliationEvaluation::setRates(const Parameters &parameters) {
           parameters[(e * _rates.size() + d) % parameters.dimensions()];
     }
   }
-  _evaluators->setRates(_rates);
+  if (!isModelReleased()) {
+    getModel().setRates(_rates);
+  }
+}
+
+void ReconciliationEvaluation::setHighways(
+    const std::vector<Highway> &highways) {
+  _highways = highways;
+  if (isModelReleased()) {
+    return;
+  }
+  getModel().setHighways(_highways);
+  if (_rates.size()) {
+    getModel().setRates(_rates);
+  }
 }
 
 corax_unode_t *ReconciliationEvaluation::getRoot() {
-  return _evaluators->getRoot();
+  // there is no gene root in the amalgamated mode
+  return _evaluators ? _evaluators->getRoot() : _releasedRoot;
 }
 
 void ReconciliationEvaluation::setRoot(corax_unode_t *root) {
-  _evaluators->setRoot(root);
+  if (_evaluators) {
+    _evaluators->setRoot(root);
+  } else if (!isAmalgamated()) {
+    _releasedRoot = root;
+  } else {
+    assert(!root);
+  }
 }
 
 double ReconciliationEvaluation::evaluate() {
-  return _evaluators->computeLogLikelihood();
+  useModel();
+  return getModel().computeLogLikelihood();
 }
 
 void ReconciliationEvaluation::invalidateCLV(unsigned int nodeIndex) {
-  _evaluators->invalidateCLV(nodeIndex);
+  // in the amalgamated mode, all clade CLVs are recomputed anyway
+  if (_evaluators) {
+    _evaluators->invalidateCLV(nodeIndex);
+  }
 }
 
 void ReconciliationEvaluation::invalidateAllCLVs() {
-  _evaluators->invalidateAllCLVs();
+  if (_evaluators) {
+    _evaluators->invalidateAllCLVs();
+  }
 }
 
 void ReconciliationEvaluation::invalidateAllSpeciesCLVs() {
-  _evaluators->invalidateAllSpeciesCLVs();
+  if (_evaluators) {
+    _evaluators->invalidateAllSpeciesCLVs();
+  } else if (_multiModel) {
+    _multiModel->invalidateAllSpeciesNodes();
+  }
 }
 
 GTBaseReconciliationInterface *
@@ -77,7 +239,15 @@ ReconciliationEvaluation::buildRecModelObject(RecModel recModel,
     }
     break;
   case RecModel::UndatedDTL:
-    if (infinitePrecision) {
+    if (_integratePolytomies) {
+      if (infinitePrecision) {
+        res = new PolytomyDTLModel<ScaledValue>(
+            _speciesTree, _geneSpeciesMapping, _recModelInfo);
+      } else {
+        res = new PolytomyDTLModel<double>(_speciesTree, _geneSpeciesMapping,
+                                           _recModelInfo);
+      }
+    } else if (infinitePrecision) {
       res = new UndatedDTLModel<ScaledValue>(_speciesTree, _geneSpeciesMapping,
                                              _recModelInfo);
     } else {
@@ -102,9 +272,9 @@ ReconciliationEvaluation::buildRecModelObject(RecModel recModel,
   if (_forcedRootedGeneTree.size() > 0) {
     auto rootedGeneTree =
         PLLRootedTree::buildFromStrOrFile(_forcedRootedGeneTree);
-    forcedGeneRoot = _initialGeneTree.getRoot(*rootedGeneTree);
+    forcedGeneRoot = _initialGeneTree->getRoot(*rootedGeneTree);
   }
-  res->setInitialGeneTree(_initialGeneTree, forcedGeneRoot);
+  res->setInitialGeneTree(*_initialGeneTree, forcedGeneRoot);
   return res;
 }
 
@@ -113,26 +283,51 @@ void ReconciliationEvaluation::updatePrecision(bool infinitePrecision) {
     _infinitePrecision = infinitePrecision;
     delete _evaluators;
     _evaluators = buildRecModelObject(_recModelInfo.model, _infinitePrecision);
+    _evaluators->setPartialLikelihoodMode(_partialLikelihoodMode);
+    _evaluators->setHighways(_highways);
     _evaluators->setRates(_rates);
   }
 }
+void ReconciliationEvaluation::updatePolytomyIntegration(
+    bool integratePolytomies) {
+  if (integratePolytomies != _integratePolytomies) {
+    _integratePolytomies = integratePolytomies;
+    delete _evaluators;
+    _evaluators = buildRecModelObject(_recModelInfo.model, _infinitePrecision);
+    _evaluators->setPartialLikelihoodMode(_partialLikelihoodMode);
+    _evaluators->setHighways(_highways);
+    _evaluators->setRates(_rates);
+  }
+}
+
 void ReconciliationEvaluation::inferMLScenario(Scenario &scenario) {
+  // scenarios are only defined on the binary gene tree
+  assert(!isAmalgamated());
+  useModel();
+  auto integratePolytomies = _integratePolytomies;
+  updatePolytomyIntegration(false);
   auto infinitePrecision = _infinitePrecision;
   updatePrecision(true);
   auto ll = evaluate();
   assert(std::isfinite(ll) && ll <= 0.0);
   assert(_evaluators->inferMLScenario(scenario));
   updatePrecision(infinitePrecision);
+  updatePolytomyIntegration(integratePolytomies);
 }
 
 void ReconciliationEvaluation::sampleReconciliations(
     unsigned int samples, std::vector<std::shared_ptr<Scenario>> &scenarios) {
+  assert(!isAmalgamated());
+  useModel();
+  auto integratePolytomies = _integratePolytomies;
+  updatePolytomyIntegration(false);
   auto infinitePrecision = _infinitePrecision;
   updatePrecision(true);
   auto ll = evaluate();
   assert(std::isfinite(ll) && ll <= 0.0);
   assert(_evaluators->sampleReconciliations(samples, scenarios));
   updatePrecision(infinitePrecision);
+  updatePolytomyIntegration(integratePolytomies);
 }
 
 corax_unode_t *ReconciliationEvaluation::computeMLRoot() {
@@ -140,6 +335,8 @@ corax_unode_t *ReconciliationEvaluation::computeMLRoot() {
 }
 
 corax_unode_t *ReconciliationEvaluation::inferMLRoot() {
+  assert(!isAmalgamated());
+  useModel();
   auto infinitePrecision = _infinitePrecision;
   updatePrecision(true);
   auto ll = evaluate();
@@ -151,17 +348,23 @@ corax_unode_t *ReconciliationEvaluation::inferMLRoot() {
 }
 
 void ReconciliationEvaluation::onSpeciesDatesChange() {
-  assert(_evaluators);
-  _evaluators->onSpeciesDatesChange();
+  // a released model is rebuilt from the current species tree
+  if (!isModelReleased()) {
+    getModel().onSpeciesDatesChange();
+  }
 }
 
 void ReconciliationEvaluation::onSpeciesTreeChange(
     const std::unordered_set<corax_rnode_t *> *nodesToInvalidate) {
-  assert(_evaluators);
-  _evaluators->onSpeciesTreeChange(nodesToInvalidate);
+  if (!isModelReleased()) {
+    getModel().onSpeciesTreeChange(nodesToInvalidate);
+  }
 }
 
 void ReconciliationEvaluation::setPartialLikelihoodMode(
     PartialLikelihoodMode mode) {
-  _evaluators->setPartialLikelihoodMode(mode);
+  _partialLikelihoodMode = mode;
+  if (_evaluators) {
+    _evaluators->setPartialLikelihoodMode(mode);
+  }
 }
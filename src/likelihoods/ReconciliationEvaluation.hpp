@@ -1,6 +1,7 @@
 #pragma once
 
 #include <IO/GeneSpeciesMapping.hpp>
+#include <IO/HighwayCandidateParser.hpp>
 #include <maths/DTLRates.hpp>
 #include <maths/Parameters.hpp>
 #include <memory>
@@ -10,7 +11,11 @@
 #include <util/enums.hpp>
 #include <vector>
 
+class BaseReconciliationModel;
+class ConditionalClades;
+class EvaluationMemoryManager;
 class GTBaseReconciliationInterface;
+class MultiModelInterface;
 class Scenario;
 
 /**
@@ -33,6 +38,23 @@ public:
                            const RecModelInfo &recModelInfo,
                            const std::string &forcedRootedGeneTree);
 
+  /**
+   *  Constructor for the amalgamated mode: the likelihood integrates
+   *  over all the gene trees described by the conditional clade
+   *  probabilities. Only the UndatedDL and UndatedDTL models are
+   *  supported, and the gene tree specific methods (roots, CLVs,
+   *  scenarios) are not available.
+   *  @param speciesTree rooted species tree (std::fixed)
+   *  @param ccp conditional clade probabilities of the gene family,
+   *         shared with the caller to avoid reloading or copying it
+   *  @param geneSpeciesMapping gene-to-species geneSpeciesMapping
+   *  @param recModelInfo description of the reconciliation model
+   */
+  ReconciliationEvaluation(PLLRootedTree &speciesTree,
+                           std::shared_ptr<const ConditionalClades> ccp,
+                           const GeneSpeciesMapping &geneSpeciesMapping,
+                           const RecModelInfo &recModelInfo);
+
   /**
    * Forbid copy
    */
@@ -44,6 +66,12 @@ public:
   ~ReconciliationEvaluation();
   void setRates(const Parameters &parameters);
 
+  /**
+   *  Account for the given transfer highways on top of the current
+   *  rates (an empty vector removes all highways)
+   */
+  void setHighways(const std::vector<Highway> &highways);
+
   /**
    * Get the current root of the gene tree. Return null if the tree does not
    * have a current root (in unrooted mode) This method is mostly used for
@@ -89,25 +117,73 @@ public:
   RecModel getRecModel() const { return _recModelInfo.model; }
   const RecModelInfo &getRecModelInfo() const { return _recModelInfo; }
 
+  /**
+   *  True if the likelihood integrates over the gene trees of a CCP
+   */
+  bool isAmalgamated() const { return _ccp != nullptr; }
+
+  /**
+   *  Let a memory manager release the model of this evaluation when
+   *  its per-rank budget is exceeded (null for no budget)
+   */
+  void setMemoryManager(std::shared_ptr<EvaluationMemoryManager> manager);
+
+  /**
+   *  Free the reconciliation model and its CLVs. The gene tree (or
+   *  CCP), rates, highways and gene root are kept, and the model is
+   *  rebuilt on the next evaluation
+   */
+  void releaseModel();
+  bool isModelReleased() const { return !_evaluators && !_multiModel; }
+
+  /**
+   *  Estimated memory footprint of the model (mostly its CLVs), in
+   *  bytes
+   */
+  size_t getModelMemoryFootprint() const;
+
 private:
   PLLRootedTree &_speciesTree;
-  PLLUnrootedTree &_initialGeneTree;
+  PLLUnrootedTree *_initialGeneTree;
   GeneSpeciesMapping _geneSpeciesMapping;
   RecModelInfo _recModelInfo;
   bool _infinitePrecision;
+  // integrate over the resolutions of the contracted gene tree
+  // branches (see PolytomyDTLModel)
+  bool _integratePolytomies;
   std::vector<std::vector<double>> _rates;
+  std::vector<Highway> _highways;
   // we actually own this pointer, but we do not
   // wrap it into a unique_ptr to allow forward definition
   GTBaseReconciliationInterface *_evaluators;
+  // set instead of _evaluators in the amalgamated mode (owned too)
+  MultiModelInterface *_multiModel;
   std::string _forcedRootedGeneTree;
+  // the CCP of the amalgamated mode, referenced by _multiModel
+  std::shared_ptr<const ConditionalClades> _ccp;
+  // state restored when rebuilding a released model
+  PartialLikelihoodMode _partialLikelihoodMode;
+  corax_unode_t *_releasedRoot;
+  std::shared_ptr<EvaluationMemoryManager> _memoryManager;
+  unsigned int _memoryId;
 
 private:
+  BaseReconciliationModel &getModel();
   GTBaseReconciliationInterface *buildRecModelObject(RecModel recModel,
                                                      bool infinitePrecision);
+  MultiModelInterface *buildMultiModelObject();
+  /**
+   *  Rebuild the model if it was released, and notify the memory
+   *  manager that it is being used
+   */
+  void useModel();
+  void rebuildModel();
   corax_unode_t *computeMLRoot();
   void updatePrecision(bool infinitePrecision);
+  void updatePolytomyIntegration(bool integratePolytomies);
 };
 
 using Evaluations = std::vector<std::shared_ptr<ReconciliationEvaluation>>;
 using PerCoreEvaluations =
     std::vector<std::shared_ptr<ReconciliationEvaluation>>;
+using PerCoreCCPs = std::vector<std::shared_ptr<const ConditionalClades>>;
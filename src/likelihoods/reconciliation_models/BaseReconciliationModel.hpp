@@ -7,6 +7,7 @@
 #include <numeric>
 
 #include <IO/GeneSpeciesMapping.hpp>
+#include <IO/HighwayCandidateParser.hpp>
 #include <IO/Logger.hpp>
 #include <maths/Random.hpp>
 #include <maths/ScaledValue.hpp>
@@ -40,6 +41,15 @@ public:
    */
   virtual void setRates(const RatesVector &rates) = 0;
 
+  /**
+   *  Set the transfer highways to account for. Their probabilities
+   *  are normalized with the branch rates, so setRates must be called
+   *  afterwards. Models without transfers ignore highways.
+   */
+  virtual void setHighways(const std::vector<Highway> &highways) {
+    (void)highways;
+  }
+
   /**
    *  Should be called after changing speciation order on a fixed
    *  species tree topology
@@ -188,7 +198,7 @@ protected:
   std::vector<corax_rnode_t *> _prunedSpeciesNodes;
   // map species leaf names to species leaf indices. Species leaf indices run
   // from 0 to (_speciesTree.getLeafNumber() - 1)
-  std::map<std::string, unsigned int> _speciesNameToId;
+  StringToUint _speciesNameToId;
   // map gene leaf names to species leaf names
   std::map<std::string, std::string> _geneNameToSpeciesName;
   // map gene leaf indices to species leaf indices
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "BaseReconciliationModel.hpp"
+#include <ccp/ConditionalClades.hpp>
+
+/**
+ *  Reconciliation model that integrates over all the gene trees
+ *  that can be amalgamated from the conditional clade probabilities
+ *  (CCP) of a gene family, instead of using a single gene tree.
+ *
+ *  CLVs are indexed by clade IDs (CID). Child clades always have a
+ *  smaller CID than their parents, so the CLVs are filled in CID
+ *  order, and the likelihood of a clade sums the likelihoods of its
+ *  splits weighted by their frequencies. The last CID is the clade
+ *  containing all genes: its splits are the root positions.
+ *
+ *  With a CCP built from a single unrooted gene tree, the likelihood
+ *  is the one of the gene tree model, divided by its number of root
+ *  positions.
+ *
+ *  The CCP is referenced, not copied: it must outlive the model.
+ */
+class MultiModelInterface : public BaseReconciliationModel {
+public:
+  MultiModelInterface(PLLRootedTree &speciesTree,
+                      const GeneSpeciesMapping &geneSpeciesMapping,
+                      const RecModelInfo &recModelInfo,
+                      const ConditionalClades &ccp)
+      : BaseReconciliationModel(speciesTree, geneSpeciesMapping, recModelInfo),
+        _ccp(ccp) {
+    mapGenesToSpecies();
+  }
+
+  virtual ~MultiModelInterface() {}
+
+  /**
+   *  Scenarios are defined on a single gene tree, they are not
+   *  available when integrating over the CCP
+   */
+  virtual bool inferMLScenario(Scenario &) { return false; }
+  virtual bool sampleReconciliations(unsigned int,
+                                     std::vector<std::shared_ptr<Scenario>> &) {
+    return false;
+  }
+
+  const ConditionalClades &getCCP() const { return _ccp; }
+
+protected:
+  CID getRootCID() const { return _ccp.getCladesNumber() - 1; }
+
+  /**
+   *  Map the leaf clades to the species leaves
+   */
+  virtual void mapGenesToSpecies();
+
+  /**
+   *  Compute the species LCA of each clade. Must be called after
+   *  each species tree topology change
+   */
+  void updateCladeSpeciesLCAs();
+
+  const ConditionalClades &_ccp;
+  // species LCA of the genes of each clade, indexed by CID
+  std::vector<corax_rnode_t *> _cladeToSpeciesLCA;
+};
+
+template <class REAL> class MultiModel : public MultiModelInterface {
+public:
+  MultiModel(PLLRootedTree &speciesTree,
+             const GeneSpeciesMapping &geneSpeciesMapping,
+             const RecModelInfo &recModelInfo, const ConditionalClades &ccp)
+      : MultiModelInterface(speciesTree, geneSpeciesMapping, recModelInfo,
+                            ccp) {}
+
+  virtual ~MultiModel() {}
+
+  virtual double computeLogLikelihood();
+
+protected:
+  /**
+   *  Compute the CLV of a clade, assuming that the CLVs of all its
+   *  child clades are up to date
+   */
+  virtual void updateCLV(CID cid) = 0;
+  /**
+   *  Likelihood of the root clade, summed over the species nodes
+   */
+  virtual REAL getRootCladeLikelihood() const = 0;
+  virtual REAL getLikelihoodFactor() const = 0;
+};
+
+inline void MultiModelInterface::mapGenesToSpecies() {
+  _geneToSpecies.clear();
+  _cladeToSpeciesLCA.assign(_ccp.getCladesNumber(), nullptr);
+  _numberOfCoveredSpecies = 0;
+  _speciesCoverage = std::vector<unsigned int>(getAllSpeciesNodeNumber(), 0);
+  for (const auto &pair : _ccp.getCidToLeaves()) {
+    const auto &speciesName = _geneNameToSpeciesName[pair.second];
+    auto spid = _speciesNameToId[speciesName];
+    _geneToSpecies[pair.first] = spid;
+    if (!_speciesCoverage[spid]) {
+      _numberOfCoveredSpecies++;
+    }
+    _speciesCoverage[spid]++;
+  }
+  onSpeciesTreeChange(nullptr);
+}
+
+inline void MultiModelInterface::updateCladeSpeciesLCAs() {
+  for (CID cid = 0; cid < _ccp.getCladesNumber(); ++cid) {
+    if (_ccp.isLeaf(cid)) {
+      _cladeToSpeciesLCA[cid] = _speciesTree.getNode(_geneToSpecies[cid]);
+      continue;
+    }
+    // all the splits of a clade give the same LCA
+    const auto &split = _ccp.getCladeSplits(cid).front();
+    _cladeToSpeciesLCA[cid] = _speciesTree.getLCA(
+        _cladeToSpeciesLCA[split.left], _cladeToSpeciesLCA[split.right]);
+  }
+}
+
+template <class REAL> double MultiModel<REAL>::computeLogLikelihood() {
+  beforeComputeCLVs();
+  updateCladeSpeciesLCAs();
+  for (CID cid = 0; cid < _ccp.getCladesNumber(); ++cid) {
+    updateCLV(cid);
+  }
+  return getLog(getRootCladeLikelihood()) - getLog(getLikelihoodFactor());
+}
@@ -0,0 +1,576 @@
+#pragma once
+
+#include <IO/GeneSpeciesMapping.hpp>
+#include <IO/LibpllException.hpp>
+#include <IO/Logger.hpp>
+#include <likelihoods/reconciliation_models/GTBaseReconciliationModel.hpp>
+
+/*
+ *  Undated DTL model (same equations as UndatedDTLModel) in which
+ *  the gene tree branches with lengths <= branchLengthThreshold are
+ *  contracted, and the likelihood is averaged over all the binary
+ *  resolutions of the resulting polytomies.
+ *
+ *  For a polytomy with children c_1...c_m, the sum over all rooted
+ *  binary trees on a set S of children is obtained from the sums over
+ *  the subsets of S, because each binary tree has a unique root split
+ *  and the CLV recursion is bilinear in the children CLVs. This costs
+ *  O(3^m) CLV combinations, so polytomies are only contracted up to
+ *  maxPolytomySize children.
+ *
+ *  The likelihood is summed over the root positions on the
+ *  non-contracted branches. Only the NONE and PARENTS transfer
+ *  constraints are supported, and transfer highways are rejected.
+ *  Scenarios are not implemented: callers should infer them with the
+ *  binary model.
+ *
+ *  The contracted structure of the gene tree is cached. After a gene
+ *  tree change signaled with invalidateCLV or invalidateAllCLVs, it is
+ *  only rebuilt if the topology or the set of contracted branches
+ *  changed. In the PartialGenes mode, only the CLVs above the
+ *  invalidated gene nodes are recomputed, unless the species tree or
+ *  the rates changed.
+ */
+template <class REAL>
+class PolytomyDTLModel : public GTBaseReconciliationInterface {
+public:
+  static const unsigned int maxPolytomySize = 10;
+
+  PolytomyDTLModel(PLLRootedTree &speciesTree,
+                   const GeneSpeciesMapping &geneSpeciesMapping,
+                   const RecModelInfo &recModelInfo)
+      : GTBaseReconciliationInterface(speciesTree, geneSpeciesMapping,
+                                      recModelInfo),
+        _geneTree(nullptr), _geneRoot(nullptr), _structureInvalid(true),
+        _maxChildren(2), _allCLVsInvalid(true),
+        _likelihoodMode(PartialLikelihoodMode::PartialGenes) {
+    assert(recModelInfo.transferConstraint != TransferConstaint::RELDATED);
+  }
+  PolytomyDTLModel(const PolytomyDTLModel &) = delete;
+  PolytomyDTLModel &operator=(const PolytomyDTLModel &) = delete;
+  PolytomyDTLModel(PolytomyDTLModel &&) = delete;
+  PolytomyDTLModel &operator=(PolytomyDTLModel &&) = delete;
+  virtual ~PolytomyDTLModel() {}
+
+  // overloaded from parent
+  virtual void setRates(const RatesVector &rates);
+  virtual void setHighways(const std::vector<Highway> &highways) {
+    if (highways.size()) {
+      throw LibpllException("The polytomy DTL model does not support "
+                            "transfer highways");
+    }
+  }
+  virtual double computeLogLikelihood();
+  virtual void setInitialGeneTree(PLLUnrootedTree &tree,
+                                  corax_unode_t *forcedGeneRoot);
+  virtual bool isParsimony() const { return false; }
+  virtual void setRoot(corax_unode_t *root) { _geneRoot = root; }
+  virtual corax_unode_t *getRoot() { return _geneRoot; }
+  virtual void setPartialLikelihoodMode(PartialLikelihoodMode mode) {
+    _likelihoodMode = mode;
+  }
+  virtual void invalidateAllSpeciesCLVs() { this->invalidateAllSpeciesNodes(); }
+  virtual void invalidateAllCLVs() { _allCLVsInvalid = true; }
+  virtual void invalidateCLV(unsigned int geneNodeIndex) {
+    _invalidatedNodes.push_back(geneNodeIndex);
+  }
+  virtual void enableMADRooting(bool) {}
+  virtual corax_unode_t *computeMLRoot() { return _geneRoot; }
+  virtual bool inferMLScenario(Scenario &) { return false; }
+  virtual bool sampleReconciliations(unsigned int,
+                                     std::vector<std::shared_ptr<Scenario>> &) {
+    return false;
+  }
+
+protected:
+  // overloaded from parent
+  virtual void mapGenesToSpecies();
+  virtual void recomputeSpeciesProbabilities();
+
+private:
+  struct DTLCLV {
+    DTLCLV() : _survivingTransferSums(REAL()) {}
+    std::vector<REAL> _uq;
+    std::vector<REAL> _correctionSum;
+    REAL _survivingTransferSums;
+
+    void reset(size_t speciesNumber) {
+      _uq.assign(speciesNumber, REAL());
+      _correctionSum.assign(speciesNumber, REAL());
+      _survivingTransferSums = REAL();
+    }
+  };
+
+  // model
+  std::vector<double> _PD;
+  std::vector<double> _PL;
+  std::vector<double> _PT;
+  std::vector<double> _PS;
+  std::vector<double> _uE;
+  // gene tree
+  PLLUnrootedTree *_geneTree;
+  corax_unode_t *_geneRoot;
+  // all directed gene nodes, indexed by node index
+  std::vector<corax_unode_t *> _allNodes;
+  // binary children (two per directed gene node) and contracted
+  // branches when the structure below was built, to detect changes
+  std::vector<corax_unode_t *> _builtChildren;
+  std::vector<bool> _builtContracted;
+  // for each directed gene node, its (possibly more than two) children
+  std::vector<std::vector<corax_unode_t *>> _children;
+  // directed gene nodes needed by the likelihood, in postorder
+  std::vector<corax_unode_t *> _nodesToCompute;
+  // non-contracted branches, used as root positions
+  std::vector<corax_unode_t *> _roots;
+  // true if the structure above must be rebuilt
+  bool _structureInvalid;
+  // largest number of children of a node in _nodesToCompute
+  unsigned int _maxChildren;
+  // incremental CLV updates
+  bool _allCLVsInvalid;
+  std::vector<unsigned int> _invalidatedNodes;
+  std::vector<bool> _isCLVUpdated;
+  PartialLikelihoodMode _likelihoodMode;
+  std::vector<DTLCLV> _dtlclvs;
+  std::vector<corax_rnode_t *> _geneToSpeciesLCA;
+  // buffers for the polytomy dynamic programming, indexed by subsets,
+  // and for the root positions. They are reused across evaluations
+  std::vector<DTLCLV> _subsetCLVs;
+  std::vector<corax_rnode_t *> _subsetLCAs;
+  DTLCLV _rootCLV;
+
+private:
+  bool isContracted(corax_unode_t *branch) const {
+    return branch->next && branch->back->next &&
+           branch->length <= this->_info.branchLengthThreshold;
+  }
+  void fillChildren(corax_unode_t *node,
+                    std::vector<corax_unode_t *> &children) const;
+  void updateStructure();
+  bool isTopologyChanged() const;
+  bool isContractionChanged() const;
+  void markInvalidatedNodes();
+  void updateCLV(corax_unode_t *geneNode);
+  void updateLeafCLV(corax_unode_t *geneNode, DTLCLV &clv);
+  void addSplitTerms(const DTLCLV &left, const DTLCLV &right, DTLCLV &clv,
+                     const std::vector<bool> *allowedSpecies);
+  void finalizeCLV(DTLCLV &clv, const std::vector<bool> *allowedSpecies);
+  REAL getCorrectedTransferSum(const DTLCLV &clv, unsigned int e) const {
+    if (this->_info.transferConstraint == TransferConstaint::NONE) {
+      return (clv._survivingTransferSums -
+              clv._uq[e] * (1.0 / double(this->_allSpeciesNodes.size()))) *
+             _PT[e];
+    }
+    return (clv._survivingTransferSums - clv._correctionSum[e]) * _PT[e];
+  }
+  /**
+   *  Number of rooted binary trees with m leaves: (2m - 3)!!
+   */
+  static double countRootedResolutions(unsigned int m) {
+    double res = 1.0;
+    for (unsigned int i = 3; i + 3 <= 2 * m; i += 2) {
+      res *= static_cast<double>(i);
+    }
+    return res;
+  }
+};
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::setRates(const RatesVector &rates) {
+  assert(rates.size() == 3);
+  _PD = rates[0];
+  _PL = rates[1];
+  _PT = rates[2];
+  _PS.resize(_PD.size());
+  for (unsigned int e = 0; e < _PD.size(); ++e) {
+    if (this->_info.noDup) {
+      _PD[e] = 0.0;
+    }
+    auto sum = _PD[e] + _PL[e] + _PT[e] + 1.0;
+    _PD[e] /= sum;
+    _PL[e] /= sum;
+    _PT[e] /= sum;
+    _PS[e] = 1.0 / sum;
+  }
+  recomputeSpeciesProbabilities();
+  this->invalidateAllSpeciesCLVs();
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::recomputeSpeciesProbabilities() {
+  _uE.resize(_PD.size());
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    _uE[speciesNode->node_index] = 0.0;
+  }
+  const unsigned int iterations = 4;
+  double transferExtinctionSum = 0.0;
+  double N = this->_allSpeciesNodes.size();
+  for (unsigned int it = 0; it < iterations; ++it) {
+    for (auto speciesNode : this->_allSpeciesNodes) {
+      auto e = speciesNode->node_index;
+      if (it + 1 == iterations && !speciesNode->left) {
+        _uE[e] = _uE[e] * (1.0 - this->_fm[e]) + this->_fm[e];
+        continue;
+      }
+      double proba = _PL[e] + (_PD[e] * _uE[e] * _uE[e]) +
+                     _PT[e] * transferExtinctionSum * _uE[e];
+      if (this->getSpeciesLeft(speciesNode)) {
+        proba += _uE[this->getSpeciesLeft(speciesNode)->node_index] *
+                 _uE[this->getSpeciesRight(speciesNode)->node_index] * _PS[e];
+      }
+      _uE[e] = proba;
+    }
+    transferExtinctionSum = 0.0;
+    for (auto speciesNode : this->_allSpeciesNodes) {
+      transferExtinctionSum += _uE[speciesNode->node_index];
+    }
+    transferExtinctionSum /= N;
+  }
+}
+
+template <class REAL> void PolytomyDTLModel<REAL>::mapGenesToSpecies() {
+  this->_geneToSpecies.clear();
+  this->_numberOfCoveredSpecies = 0;
+  this->_speciesCoverage =
+      std::vector<unsigned int>(this->getAllSpeciesNodeNumber(), 0);
+  for (auto leaf : _geneTree->getLeaves()) {
+    auto speciesName = this->_geneNameToSpeciesName[std::string(leaf->label)];
+    auto spid = this->_speciesNameToId[speciesName];
+    this->_geneToSpecies[leaf->node_index] = spid;
+    if (!this->_speciesCoverage[spid]) {
+      this->_numberOfCoveredSpecies++;
+    }
+    this->_speciesCoverage[spid]++;
+  }
+  this->onSpeciesTreeChange(nullptr);
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::fillChildren(
+    corax_unode_t *node, std::vector<corax_unode_t *> &children) const {
+  children.clear();
+  if (!node->next) {
+    return;
+  }
+  children.push_back(node->next->back);
+  children.push_back(node->next->next->back);
+  for (unsigned int i = 0; i < children.size();) {
+    auto child = children[i];
+    if (isContracted(child) && children.size() < maxPolytomySize) {
+      children[i] = child->next->back;
+      children.push_back(child->next->next->back);
+    } else {
+      ++i;
+    }
+  }
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::setInitialGeneTree(PLLUnrootedTree &tree,
+                                                corax_unode_t *) {
+  _geneTree = &tree;
+  _geneRoot = nullptr;
+  _allNodes.assign(tree.getDirectedNodeNumber(), nullptr);
+  for (auto node : tree.getPostOrderNodes()) {
+    _allNodes[node->node_index] = node;
+  }
+  mapGenesToSpecies();
+  updateStructure();
+  _allCLVsInvalid = true;
+}
+
+template <class REAL> void PolytomyDTLModel<REAL>::updateStructure() {
+  auto &tree = *_geneTree;
+  auto directedNodes = tree.getDirectedNodeNumber();
+  _children.resize(directedNodes);
+  _dtlclvs.resize(directedNodes);
+  _geneToSpeciesLCA.resize(directedNodes);
+  _builtChildren.assign(2 * directedNodes, nullptr);
+  _builtContracted.resize(directedNodes);
+  for (auto node : _allNodes) {
+    auto index = node->node_index;
+    if (node->next) {
+      _builtChildren[2 * index] = node->next->back;
+      _builtChildren[2 * index + 1] = node->next->next->back;
+    }
+    _builtContracted[index] = isContracted(node);
+  }
+  _roots.clear();
+  std::vector<bool> needed(directedNodes, false);
+  for (auto branch : tree.getBranchesDeterministic()) {
+    if (!isContracted(branch)) {
+      _roots.push_back(branch);
+      needed[branch->node_index] = true;
+      needed[branch->back->node_index] = true;
+    }
+  }
+  assert(_roots.size());
+  // mark the nodes reachable from the roots, from the root to the tips
+  auto postOrder = tree.getPostOrderNodes();
+  for (auto it = postOrder.rbegin(); it != postOrder.rend(); ++it) {
+    auto node = *it;
+    if (!needed[node->node_index]) {
+      continue;
+    }
+    fillChildren(node, _children[node->node_index]);
+    for (auto child : _children[node->node_index]) {
+      needed[child->node_index] = true;
+    }
+  }
+  _nodesToCompute.clear();
+  _maxChildren = 2;
+  for (auto node : postOrder) {
+    if (needed[node->node_index]) {
+      _nodesToCompute.push_back(node);
+      _maxChildren = std::max(
+          _maxChildren,
+          static_cast<unsigned int>(_children[node->node_index].size()));
+    }
+  }
+  if (_maxChildren > 2 && _subsetCLVs.size() < (1u << _maxChildren)) {
+    _subsetCLVs.resize(1u << _maxChildren);
+    _subsetLCAs.resize(1u << _maxChildren);
+  }
+  _structureInvalid = false;
+}
+
+template <class REAL> bool PolytomyDTLModel<REAL>::isTopologyChanged() const {
+  for (auto node : _allNodes) {
+    auto index = node->node_index;
+    if (node->next &&
+        (node->next->back != _builtChildren[2 * index] ||
+         node->next->next->back != _builtChildren[2 * index + 1])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class REAL>
+bool PolytomyDTLModel<REAL>::isContractionChanged() const {
+  for (auto node : _allNodes) {
+    if (isContracted(node) != _builtContracted[node->node_index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class REAL> void PolytomyDTLModel<REAL>::markInvalidatedNodes() {
+  // a CLV depends on all the gene nodes below it: invalidate the
+  // directed nodes from each invalidated node up to the tree borders
+  std::vector<corax_unode_t *> toMark;
+  for (auto index : _invalidatedNodes) {
+    toMark.push_back(_allNodes[index]);
+  }
+  while (!toMark.empty()) {
+    auto node = toMark.back();
+    toMark.pop_back();
+    _isCLVUpdated[node->node_index] = false;
+    if (node->back->next) {
+      toMark.push_back(node->back->next);
+      toMark.push_back(node->back->next->next);
+    }
+  }
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::addSplitTerms(
+    const DTLCLV &left, const DTLCLV &right, DTLCLV &clv,
+    const std::vector<bool> *allowedSpecies) {
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    auto e = speciesNode->node_index;
+    if (allowedSpecies && !(*allowedSpecies)[e]) {
+      continue;
+    }
+    // D event
+    REAL proba = left._uq[e] * right._uq[e];
+    proba *= _PD[e];
+    // S event
+    if (this->getSpeciesLeft(speciesNode)) {
+      auto f = this->getSpeciesLeft(speciesNode)->node_index;
+      auto g = this->getSpeciesRight(speciesNode)->node_index;
+      REAL speciation = left._uq[f] * right._uq[g];
+      speciation += left._uq[g] * right._uq[f];
+      speciation *= _PS[e];
+      proba += speciation;
+    }
+    // T event
+    proba += getCorrectedTransferSum(left, e) * right._uq[e];
+    proba += getCorrectedTransferSum(right, e) * left._uq[e];
+    scale(proba);
+    clv._uq[e] += proba;
+  }
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::finalizeCLV(
+    DTLCLV &clv, const std::vector<bool> *allowedSpecies) {
+  auto N = static_cast<double>(this->_allSpeciesNodes.size());
+  // SL events, in species postorder
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    auto e = speciesNode->node_index;
+    if ((allowedSpecies && !(*allowedSpecies)[e]) ||
+        !this->getSpeciesLeft(speciesNode)) {
+      continue;
+    }
+    auto f = this->getSpeciesLeft(speciesNode)->node_index;
+    auto g = this->getSpeciesRight(speciesNode)->node_index;
+    REAL proba = clv._uq[f] * (_uE[g] * _PS[e]);
+    proba += clv._uq[g] * (_uE[f] * _PS[e]);
+    scale(proba);
+    clv._uq[e] += proba;
+  }
+  // transfer sums
+  REAL sum = REAL();
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    sum += clv._uq[speciesNode->node_index];
+  }
+  clv._survivingTransferSums = sum / N;
+  if (this->_info.transferConstraint == TransferConstaint::PARENTS) {
+    for (auto speciesNode : this->_allSpeciesNodes) {
+      auto e = speciesNode->node_index;
+      REAL correction = REAL();
+      for (auto parent = speciesNode; parent; parent = parent->parent) {
+        correction += clv._uq[parent->node_index];
+      }
+      clv._correctionSum[e] = correction / N;
+    }
+  }
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::updateLeafCLV(corax_unode_t *geneNode,
+                                           DTLCLV &clv) {
+  auto e = this->_geneToSpecies[geneNode->node_index];
+  _geneToSpeciesLCA[geneNode->node_index] = this->_speciesTree.getNode(e);
+  clv._uq[e] = REAL(_PS[e]);
+  finalizeCLV(clv, &this->_speciesTree.getParentsCache(
+                       _geneToSpeciesLCA[geneNode->node_index]));
+}
+
+template <class REAL>
+void PolytomyDTLModel<REAL>::updateCLV(corax_unode_t *geneNode) {
+  auto gid = geneNode->node_index;
+  auto &clv = _dtlclvs[gid];
+  clv.reset(this->_allSpeciesNodes.size());
+  if (!geneNode->next) {
+    updateLeafCLV(geneNode, clv);
+    return;
+  }
+  auto &children = _children[gid];
+  auto m = static_cast<unsigned int>(children.size());
+  if (m == 2) {
+    auto left = children[0]->node_index;
+    auto right = children[1]->node_index;
+    auto lca = this->_speciesTree.getLCA(_geneToSpeciesLCA[left],
+                                         _geneToSpeciesLCA[right]);
+    _geneToSpeciesLCA[gid] = lca;
+    auto &parents = this->_speciesTree.getParentsCache(lca);
+    addSplitTerms(_dtlclvs[left], _dtlclvs[right], clv, &parents);
+    finalizeCLV(clv, &parents);
+    return;
+  }
+  // polytomy: sum over the binary trees of each subset of children.
+  // A subset only depends on strictly smaller subsets.
+  unsigned int full = (1u << m) - 1;
+  for (unsigned int i = 0; i < m; ++i) {
+    _subsetLCAs[1u << i] = _geneToSpeciesLCA[children[i]->node_index];
+  }
+  auto getSubsetCLV = [&](unsigned int subset) -> const DTLCLV & {
+    if (!(subset & (subset - 1))) {
+      return _dtlclvs[children[__builtin_ctz(subset)]->node_index];
+    }
+    return _subsetCLVs[subset];
+  };
+  for (unsigned int subset = 3; subset <= full; ++subset) {
+    if (!(subset & (subset - 1))) {
+      continue;
+    }
+    auto lowest = subset & (~subset + 1);
+    auto lca = this->_speciesTree.getLCA(_subsetLCAs[lowest],
+                                         _subsetLCAs[subset ^ lowest]);
+    _subsetLCAs[subset] = lca;
+    auto &parents = this->_speciesTree.getParentsCache(lca);
+    auto &subsetCLV = (subset == full) ? clv : _subsetCLVs[subset];
+    subsetCLV.reset(this->_allSpeciesNodes.size());
+    // enumerate each unordered split once: the left part contains
+    // the lowest element
+    auto rest = subset ^ lowest;
+    for (unsigned int sub = (rest - 1) & rest;; sub = (sub - 1) & rest) {
+      auto leftPart = sub | lowest;
+      addSplitTerms(getSubsetCLV(leftPart), getSubsetCLV(subset ^ leftPart),
+                    subsetCLV, &parents);
+      if (!sub) {
+        break;
+      }
+    }
+    if (subset == full) {
+      double resolutions = countRootedResolutions(m);
+      for (auto &value : subsetCLV._uq) {
+        value /= resolutions;
+      }
+    }
+    finalizeCLV(subsetCLV, &parents);
+  }
+  _geneToSpeciesLCA[gid] = _subsetLCAs[full];
+}
+
+template <class REAL> double PolytomyDTLModel<REAL>::computeLogLikelihood() {
+  this->beforeComputeCLVs();
+  // any species tree or rate change affects all the CLVs
+  bool speciesChanged = this->_allSpeciesNodesInvalid ||
+                        this->_invalidatedSpeciesNodes.size();
+  this->_allSpeciesNodesInvalid = false;
+  this->_invalidatedSpeciesNodes.clear();
+  if (_allCLVsInvalid || _invalidatedNodes.size()) {
+    // a CLV only depends on the binary gene subtree below it and on
+    // the contracted branches of this subtree: after a topology change,
+    // the CLVs that were not invalidated are still valid
+    if (isContractionChanged()) {
+      _structureInvalid = true;
+      _allCLVsInvalid = true;
+    } else if (isTopologyChanged()) {
+      _structureInvalid = true;
+    }
+  }
+  if (_structureInvalid) {
+    updateStructure();
+  }
+  if (_allCLVsInvalid || speciesChanged ||
+      _likelihoodMode != PartialLikelihoodMode::PartialGenes) {
+    _isCLVUpdated.assign(_allNodes.size(), false);
+  } else {
+    markInvalidatedNodes();
+  }
+  _allCLVsInvalid = false;
+  _invalidatedNodes.clear();
+  for (auto node : _nodesToCompute) {
+    if (!_isCLVUpdated[node->node_index]) {
+      updateCLV(node);
+      _isCLVUpdated[node->node_index] = true;
+    }
+  }
+  REAL total = REAL();
+  REAL bestRootLikelihood = REAL();
+  for (auto root : _roots) {
+    _rootCLV.reset(this->_allSpeciesNodes.size());
+    addSplitTerms(_dtlclvs[root->node_index],
+                  _dtlclvs[root->back->node_index], _rootCLV, nullptr);
+    finalizeCLV(_rootCLV, nullptr);
+    REAL rootLikelihood = REAL();
+    for (auto &value : _rootCLV._uq) {
+      rootLikelihood += value;
+    }
+    if (bestRootLikelihood < rootLikelihood) {
+      bestRootLikelihood = rootLikelihood;
+      _geneRoot = root;
+    }
+    total += rootLikelihood;
+  }
+  REAL factor(0.0);
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    factor += (REAL(1.0) - REAL(_uE[speciesNode->node_index]));
+  }
+  return getLog(total) - getLog(factor);
+}
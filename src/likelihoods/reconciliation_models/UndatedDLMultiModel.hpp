@@ -0,0 +1,162 @@
+#pragma once
+
+#include <likelihoods/reconciliation_models/MultiModel.hpp>
+
+/*
+ *  Amalgamated version of UndatedDLModel: same recursion, where the
+ *  children of a gene node are replaced by the splits of a clade,
+ *  weighted by their conditional clade probabilities
+ */
+template <class REAL> class UndatedDLMultiModel : public MultiModel<REAL> {
+public:
+  UndatedDLMultiModel(PLLRootedTree &speciesTree,
+                      const GeneSpeciesMapping &geneSpeciesMapping,
+                      const RecModelInfo &recModelInfo,
+                      const ConditionalClades &ccp)
+      : MultiModel<REAL>(speciesTree, geneSpeciesMapping, recModelInfo, ccp),
+        _dlclvs(ccp.getCladesNumber(),
+                std::vector<REAL>(speciesTree.getNodeNumber())) {}
+
+  UndatedDLMultiModel(const UndatedDLMultiModel &) = delete;
+  UndatedDLMultiModel &operator=(const UndatedDLMultiModel &) = delete;
+  UndatedDLMultiModel(UndatedDLMultiModel &&) = delete;
+  UndatedDLMultiModel &operator=(UndatedDLMultiModel &&) = delete;
+  virtual ~UndatedDLMultiModel() {}
+
+  // overloaded from parent
+  virtual void setRates(const RatesVector &rates);
+
+protected:
+  // overloaded from parent
+  virtual void updateCLV(CID cid);
+  // overloaded from parent
+  virtual REAL getRootCladeLikelihood() const;
+  // overloaded from parent
+  virtual REAL getLikelihoodFactor() const;
+  // overloaded from parent
+  virtual void recomputeSpeciesProbabilities();
+
+private:
+  std::vector<double> _PD; // Duplication probability, per species branch
+  std::vector<double> _PL; // Loss probability, per species branch
+  std::vector<double> _PS; // Speciation probability, per species branch
+  std::vector<double> _uE; // Extinction probability, per species branch
+  // _dlclvs[cid][e]: probability of clade cid rooted at species e
+  std::vector<std::vector<REAL>> _dlclvs;
+
+  void computeProbability(CID cid, corax_rnode_t *speciesNode, REAL &proba);
+};
+
+template <class REAL>
+void UndatedDLMultiModel<REAL>::setRates(const RatesVector &rates) {
+  assert(rates.size() == 2);
+  _PD = rates[0];
+  _PL = rates[1];
+  _PS = std::vector<double>(_PD.size(), 1.0);
+  for (unsigned int e = 0; e < _PD.size(); ++e) {
+    double sum = _PD[e] + _PL[e] + _PS[e];
+    _PD[e] /= sum;
+    _PL[e] /= sum;
+    _PS[e] /= sum;
+  }
+  this->invalidateAllSpeciesNodes();
+}
+
+template <class REAL>
+void UndatedDLMultiModel<REAL>::recomputeSpeciesProbabilities() {
+  _uE.resize(_PD.size());
+  for (auto speciesNode : this->getAllSpeciesNodes()) {
+    auto e = speciesNode->node_index;
+    double a = _PD[e];
+    double b = -1.0;
+    double c = _PL[e];
+    if (this->getSpeciesLeft(speciesNode)) {
+      c += _PS[e] * _uE[this->getSpeciesLeft(speciesNode)->node_index] *
+           _uE[this->getSpeciesRight(speciesNode)->node_index];
+    }
+    double proba = solveSecondDegreePolynome(a, b, c);
+    ASSERT_PROBA(proba)
+    _uE[e] = proba;
+  }
+  this->_allSpeciesNodesInvalid = false;
+  this->_invalidatedSpeciesNodes.clear();
+}
+
+template <class REAL> void UndatedDLMultiModel<REAL>::updateCLV(CID cid) {
+  for (auto speciesNode : this->getAllSpeciesNodes()) {
+    computeProbability(cid, speciesNode, _dlclvs[cid][speciesNode->node_index]);
+  }
+}
+
+template <class REAL>
+void UndatedDLMultiModel<REAL>::computeProbability(CID cid,
+                                                   corax_rnode_t *speciesNode,
+                                                   REAL &proba) {
+  bool isGeneLeaf = this->_ccp.isLeaf(cid);
+  bool isSpeciesLeaf = !this->getSpeciesLeft(speciesNode);
+  auto e = speciesNode->node_index;
+  unsigned int f = 0;
+  unsigned int g = 0;
+  if (!isSpeciesLeaf) {
+    f = this->getSpeciesLeft(speciesNode)->node_index;
+    g = this->getSpeciesRight(speciesNode)->node_index;
+  }
+  proba = REAL();
+  if (isSpeciesLeaf && isGeneLeaf) {
+    if (e == this->_geneToSpecies[cid]) {
+      proba = REAL(_PS[e]);
+    }
+    return;
+  }
+  if (!isGeneLeaf) {
+    for (const auto &split : this->_ccp.getCladeSplits(cid)) {
+      const auto &left = _dlclvs[split.left];
+      const auto &right = _dlclvs[split.right];
+      REAL splitProba = REAL();
+      if (!isSpeciesLeaf) {
+        // S event
+        REAL temp = left[f] * right[g];
+        temp += left[g] * right[f];
+        temp *= _PS[e];
+        scale(temp);
+        splitProba += temp;
+      }
+      // D event
+      REAL temp = left[e] * right[e];
+      temp *= _PD[e];
+      scale(temp);
+      splitProba += temp;
+      splitProba *= split.frequency;
+      proba += splitProba;
+    }
+  }
+  if (!isSpeciesLeaf) {
+    // SL event
+    REAL temp = _dlclvs[cid][f] * (_uE[g] * _PS[e]);
+    temp += _dlclvs[cid][g] * (_uE[f] * _PS[e]);
+    scale(temp);
+    proba += temp;
+  }
+  // DL event
+  proba /= (1.0 - 2.0 * _PD[e] * _uE[e]);
+}
+
+template <class REAL>
+REAL UndatedDLMultiModel<REAL>::getRootCladeLikelihood() const {
+  REAL sum = REAL();
+  const auto &clv = _dlclvs[this->getRootCID()];
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    sum += clv[speciesNode->node_index];
+  }
+  return sum;
+}
+
+template <class REAL>
+REAL UndatedDLMultiModel<REAL>::getLikelihoodFactor() const {
+  REAL factor(0.0);
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    auto e = speciesNode->node_index;
+    factor += (REAL(1.0) - REAL(_uE[e]));
+  }
+  return factor;
+}
@@ -28,6 +28,8 @@ public:
 
   // overloaded from parent
   virtual void setRates(const RatesVector &rates);
+  // overloaded from parent
+  virtual void setHighways(const std::vector<Highway> &highways);
 
 protected:
   // overloaded from parent
@@ -64,6 +66,10 @@ private:
   std::vector<double>
       _uE; // Probability for a gene to become extinct on each brance
   TransferConstaint _transferConstraint;
+  // transfer highways, indexed by their source species
+  std::vector<std::vector<Highway>> _highways;
+  // normalized highway probabilities, parallel to _highways
+  std::vector<std::vector<double>> _PH;
 
   /**
    *  All intermediate results needed to compute the reconciliation likelihood
@@ -152,21 +158,42 @@ void UndatedDTLModel<REAL>::setRates(const RatesVector &rates) {
   _PL = lossRates;
   _PT = transferRates;
   _PS.resize(_PD.size());
+  _highways.resize(_PD.size());
+  _PH.resize(_PD.size());
   for (unsigned int e = 0; e < _PD.size(); ++e) {
     if (this->_info.noDup) {
       _PD[e] = 0.0;
     }
-    auto sum = _PD[e] + _PL[e] + _PT[e] + 1.0;
+    double highwaysSum = 0.0;
+    for (const auto &highway : _highways[e]) {
+      highwaysSum += highway.proba;
+    }
+    auto sum = _PD[e] + _PL[e] + _PT[e] + highwaysSum + 1.0;
     _PD[e] /= sum;
     _PL[e] /= sum;
     _PT[e] /= sum;
     _PS[e] = 1.0 / sum;
+    _PH[e].clear();
+    for (const auto &highway : _highways[e]) {
+      _PH[e].push_back(highway.proba / sum);
+    }
   }
   recomputeSpeciesProbabilities();
   this->invalidateAllCLVs();
   this->invalidateAllSpeciesCLVs();
 }
 
+template <class REAL>
+void UndatedDTLModel<REAL>::setHighways(const std::vector<Highway> &highways) {
+  _highways = std::vector<std::vector<Highway>>(
+      this->_speciesTree.getNodeNumber());
+  for (const auto &highway : highways) {
+    _highways[highway.src->node_index].push_back(highway);
+  }
+  // the highway probabilities are normalized in setRates
+  _PH = std::vector<std::vector<double>>(_highways.size());
+}
+
 template <class REAL> UndatedDTLModel<REAL>::~UndatedDTLModel() {}
 
 template <class REAL>
@@ -197,6 +224,10 @@ void UndatedDTLModel<REAL>::recomputeSpeciesProbabilities() {
       }
       double proba = _PL[e] + (_PD[e] * _uE[e] * _uE[e]) +
                      _PT[e] * transferExtinctionSums[e] * _uE[e];
+      for (unsigned int i = 0; i < _PH[e].size(); ++i) {
+        auto d = _highways[e][i].dest->node_index;
+        proba += _PH[e][i] * _uE[d] * _uE[e];
+      }
       if (this->getSpeciesLeft(speciesNode)) {
         proba += _uE[this->getSpeciesLeft(speciesNode)->node_index] *
                  _uE[this->getSpeciesRight(speciesNode)->node_index] * _PS[e];
@@ -420,6 +451,16 @@ void UndatedDTLModel<REAL>::computeProbability(corax_unode_t *geneNode,
     scale(values[6]);
     proba += values[5];
     proba += values[6];
+
+    // highway T events (they are not reported in scenarios)
+    for (unsigned int i = 0; i < _PH[e].size(); ++i) {
+      auto d = _highways[e][i].dest->node_index;
+      REAL highwayProba = _dtlclvs[u_left]._uq[d] * _dtlclvs[u_right]._uq[e];
+      highwayProba += _dtlclvs[u_right]._uq[d] * _dtlclvs[u_left]._uq[e];
+      highwayProba *= _PH[e][i];
+      scale(highwayProba);
+      proba += highwayProba;
+    }
   }
   if (not isSpeciesLeaf) {
     // SL event
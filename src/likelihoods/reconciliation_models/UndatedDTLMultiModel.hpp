@@ -0,0 +1,286 @@
+#pragma once
+
+#include <IO/LibpllException.hpp>
+#include <likelihoods/reconciliation_models/MultiModel.hpp>
+
+/*
+ *  Amalgamated version of UndatedDTLModel: same recursion, where the
+ *  children of a gene node are replaced by the splits of a clade,
+ *  weighted by their conditional clade probabilities.
+ *  The dated transfer constraint (RELDATED) is not supported.
+ */
+template <class REAL> class UndatedDTLMultiModel : public MultiModel<REAL> {
+public:
+  UndatedDTLMultiModel(PLLRootedTree &speciesTree,
+                       const GeneSpeciesMapping &geneSpeciesMapping,
+                       const RecModelInfo &recModelInfo,
+                       const ConditionalClades &ccp)
+      : MultiModel<REAL>(speciesTree, geneSpeciesMapping, recModelInfo, ccp),
+        _transferConstraint(recModelInfo.transferConstraint),
+        _dtlclvs(ccp.getCladesNumber(), DTLCLV(speciesTree.getNodeNumber())) {
+    if (_transferConstraint == TransferConstaint::RELDATED) {
+      throw LibpllException("The amalgamated DTL model does not support "
+                            "the RELDATED transfer constraint");
+    }
+  }
+
+  UndatedDTLMultiModel(const UndatedDTLMultiModel &) = delete;
+  UndatedDTLMultiModel &operator=(const UndatedDTLMultiModel &) = delete;
+  UndatedDTLMultiModel(UndatedDTLMultiModel &&) = delete;
+  UndatedDTLMultiModel &operator=(UndatedDTLMultiModel &&) = delete;
+  virtual ~UndatedDTLMultiModel() {}
+
+  // overloaded from parent
+  virtual void setRates(const RatesVector &rates);
+  // overloaded from parent
+  virtual void setHighways(const std::vector<Highway> &highways);
+
+protected:
+  // overloaded from parent
+  virtual void updateCLV(CID cid);
+  // overloaded from parent
+  virtual REAL getRootCladeLikelihood() const;
+  // overloaded from parent
+  virtual REAL getLikelihoodFactor() const;
+  // overloaded from parent
+  virtual void recomputeSpeciesProbabilities();
+
+private:
+  std::vector<double> _PD; // Duplication probability, per branch
+  std::vector<double> _PL; // Loss probability, per branch
+  std::vector<double> _PT; // Transfer probability, per branch
+  std::vector<double> _PS; // Speciation probability, per branch
+  // Probability for a gene to become extinct on each branch
+  std::vector<double> _uE;
+  TransferConstaint _transferConstraint;
+  // transfer highways, indexed by their source species
+  std::vector<std::vector<Highway>> _highways;
+  // normalized highway probabilities, parallel to _highways
+  std::vector<std::vector<double>> _PH;
+
+  /**
+   *  Same as UndatedDTLModel::DTLCLV, with one object per clade
+   */
+  struct DTLCLV {
+    DTLCLV(unsigned int speciesNumber)
+        : _uq(speciesNumber, REAL()), _correctionSum(speciesNumber, REAL()),
+          _survivingTransferSums(REAL()) {}
+    std::vector<REAL> _uq;
+    std::vector<REAL> _correctionSum;
+    REAL _survivingTransferSums;
+  };
+  std::vector<DTLCLV> _dtlclvs;
+
+  unsigned int getIterationsNumber() const { return 4; }
+  void computeProbability(CID cid, corax_rnode_t *speciesNode, REAL &proba);
+
+  REAL getCorrectedTransferSum(CID cid, unsigned int speciesId) const {
+    const auto &clv = _dtlclvs[cid];
+    if (_transferConstraint == TransferConstaint::PARENTS) {
+      return (clv._survivingTransferSums - clv._correctionSum[speciesId]) *
+             _PT[speciesId];
+    }
+    return (clv._survivingTransferSums -
+            clv._uq[speciesId] *
+                (1.0 / double(this->_allSpeciesNodes.size()))) *
+           _PT[speciesId];
+  }
+};
+
+template <class REAL>
+void UndatedDTLMultiModel<REAL>::setRates(const RatesVector &rates) {
+  assert(rates.size() == 3);
+  _PD = rates[0];
+  _PL = rates[1];
+  _PT = rates[2];
+  _PS.resize(_PD.size());
+  _highways.resize(_PD.size());
+  _PH.resize(_PD.size());
+  for (unsigned int e = 0; e < _PD.size(); ++e) {
+    if (this->_info.noDup) {
+      _PD[e] = 0.0;
+    }
+    double highwaysSum = 0.0;
+    for (const auto &highway : _highways[e]) {
+      highwaysSum += highway.proba;
+    }
+    auto sum = _PD[e] + _PL[e] + _PT[e] + highwaysSum + 1.0;
+    _PD[e] /= sum;
+    _PL[e] /= sum;
+    _PT[e] /= sum;
+    _PS[e] = 1.0 / sum;
+    _PH[e].clear();
+    for (const auto &highway : _highways[e]) {
+      _PH[e].push_back(highway.proba / sum);
+    }
+  }
+  this->invalidateAllSpeciesNodes();
+}
+
+template <class REAL>
+void UndatedDTLMultiModel<REAL>::setHighways(
+    const std::vector<Highway> &highways) {
+  _highways = std::vector<std::vector<Highway>>(
+      this->_speciesTree.getNodeNumber());
+  for (const auto &highway : highways) {
+    _highways[highway.src->node_index].push_back(highway);
+  }
+  // the highway probabilities are normalized in setRates
+  _PH = std::vector<std::vector<double>>(_highways.size());
+}
+
+template <class REAL>
+void UndatedDTLMultiModel<REAL>::recomputeSpeciesProbabilities() {
+  auto &speciesNodes = this->getAllSpeciesNodes();
+  _uE.assign(_PD.size(), 0.0);
+  double N = speciesNodes.size();
+  double transferExtinctionSum = 0.0;
+  for (unsigned int it = 0; it < getIterationsNumber(); ++it) {
+    for (auto speciesNode : speciesNodes) {
+      auto e = speciesNode->node_index;
+      if (it + 1 == getIterationsNumber() && !speciesNode->left) {
+        _uE[e] = _uE[e] * (1.0 - this->_fm[e]) + this->_fm[e];
+        continue;
+      }
+      double proba = _PL[e] + (_PD[e] * _uE[e] * _uE[e]) +
+                     _PT[e] * transferExtinctionSum * _uE[e];
+      for (unsigned int i = 0; i < _PH[e].size(); ++i) {
+        auto d = _highways[e][i].dest->node_index;
+        proba += _PH[e][i] * _uE[d] * _uE[e];
+      }
+      if (this->getSpeciesLeft(speciesNode)) {
+        proba += _uE[this->getSpeciesLeft(speciesNode)->node_index] *
+                 _uE[this->getSpeciesRight(speciesNode)->node_index] * _PS[e];
+      }
+      _uE[e] = proba;
+    }
+    // as in UndatedDTLModel, PARENTS uses the unconstrained sum here
+    transferExtinctionSum = 0.0;
+    for (auto speciesNode : speciesNodes) {
+      transferExtinctionSum += _uE[speciesNode->node_index];
+    }
+    transferExtinctionSum /= N;
+  }
+  this->_allSpeciesNodesInvalid = false;
+  this->_invalidatedSpeciesNodes.clear();
+}
+
+template <class REAL> void UndatedDTLMultiModel<REAL>::updateCLV(CID cid) {
+  auto &clv = _dtlclvs[cid];
+  auto &uq = clv._uq;
+  auto &correctionSum = clv._correctionSum;
+  auto &speciesNodes = this->getAllSpeciesNodes();
+  auto N = static_cast<double>(speciesNodes.size());
+  // like the virtual root of UndatedDTLModel, the root clade can be
+  // rooted at any species node
+  bool isRoot = (cid == this->getRootCID());
+  auto &parentsCache =
+      this->_speciesTree.getParentsCache(this->_cladeToSpeciesLCA[cid]);
+  std::fill(uq.begin(), uq.end(), REAL());
+  REAL sum = REAL();
+  for (auto speciesNode : speciesNodes) {
+    auto e = speciesNode->node_index;
+    if (isRoot || parentsCache[e]) {
+      computeProbability(cid, speciesNode, uq[e]);
+    }
+    sum += uq[e];
+  }
+  if (_transferConstraint == TransferConstaint::PARENTS) {
+    std::fill(correctionSum.begin(), correctionSum.end(), REAL());
+    for (auto speciesNode : speciesNodes) {
+      auto e = speciesNode->node_index;
+      auto parent = speciesNode;
+      while (parent) {
+        correctionSum[e] += uq[parent->node_index];
+        parent = parent->parent;
+      }
+      correctionSum[e] /= N;
+    }
+  }
+  sum /= N;
+  clv._survivingTransferSums = sum;
+}
+
+template <class REAL>
+void UndatedDTLMultiModel<REAL>::computeProbability(CID cid,
+                                                    corax_rnode_t *speciesNode,
+                                                    REAL &proba) {
+  auto e = speciesNode->node_index;
+  bool isGeneLeaf = this->_ccp.isLeaf(cid);
+  bool isSpeciesLeaf = !this->getSpeciesLeft(speciesNode);
+  proba = REAL();
+  if (isSpeciesLeaf && isGeneLeaf && e == this->_geneToSpecies[cid]) {
+    proba = REAL(_PS[e]);
+    return;
+  }
+  unsigned int f = 0;
+  unsigned int g = 0;
+  if (!isSpeciesLeaf) {
+    f = this->getSpeciesLeft(speciesNode)->node_index;
+    g = this->getSpeciesRight(speciesNode)->node_index;
+  }
+  if (!isGeneLeaf) {
+    for (const auto &split : this->_ccp.getCladeSplits(cid)) {
+      const auto &left = _dtlclvs[split.left]._uq;
+      const auto &right = _dtlclvs[split.right]._uq;
+      REAL splitProba = REAL();
+      if (!isSpeciesLeaf) {
+        // S event
+        REAL temp = left[f] * right[g];
+        temp += left[g] * right[f];
+        temp *= _PS[e];
+        scale(temp);
+        splitProba += temp;
+      }
+      // D event
+      REAL temp = left[e] * right[e];
+      temp *= _PD[e];
+      scale(temp);
+      splitProba += temp;
+      // T event
+      temp = getCorrectedTransferSum(split.left, e) * right[e];
+      temp += getCorrectedTransferSum(split.right, e) * left[e];
+      scale(temp);
+      splitProba += temp;
+      // highway T events
+      for (unsigned int i = 0; i < _PH[e].size(); ++i) {
+        auto d = _highways[e][i].dest->node_index;
+        temp = left[d] * right[e];
+        temp += right[d] * left[e];
+        temp *= _PH[e][i];
+        scale(temp);
+        splitProba += temp;
+      }
+      splitProba *= split.frequency;
+      proba += splitProba;
+    }
+  }
+  if (!isSpeciesLeaf) {
+    // SL event
+    const auto &uq = _dtlclvs[cid]._uq;
+    REAL temp = uq[f] * (_uE[g] * _PS[e]);
+    temp += uq[g] * (_uE[f] * _PS[e]);
+    scale(temp);
+    proba += temp;
+  }
+}
+
+template <class REAL>
+REAL UndatedDTLMultiModel<REAL>::getRootCladeLikelihood() const {
+  REAL sum = REAL();
+  const auto &uq = _dtlclvs[this->getRootCID()]._uq;
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    sum += uq[speciesNode->node_index];
+  }
+  return sum;
+}
+
+template <class REAL>
+REAL UndatedDTLMultiModel<REAL>::getLikelihoodFactor() const {
+  REAL factor(0.0);
+  for (auto speciesNode : this->_allSpeciesNodes) {
+    auto e = speciesNode->node_index;
+    factor += (REAL(1.0) - REAL(_uE[e]));
+  }
+  return factor;
+}
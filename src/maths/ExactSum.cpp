@@ -0,0 +1,125 @@
+#include "ExactSum.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <parallelization/ParallelContext.hpp>
+
+static const int LIMB_BITS = 32;
+static const int64_t LIMB_BASE = int64_t(1) << LIMB_BITS;
+static const uint64_t LIMB_MASK = uint64_t(LIMB_BASE - 1);
+// bits of a double mantissa, including the implicit bit
+static const int MANTISSA_BITS = 53;
+// the least significant bit of the accumulator is 2^MIN_EXPONENT,
+// the smallest subnormal double
+static const int MIN_EXPONENT = -1074;
+// 2098 bits cover all finite doubles, the extra limbs hold the carries
+static const unsigned int LIMBS_NUMBER = 68;
+// each addition adds less than 2^32 to a limb: propagate the carries
+// long before the 64 bits limbs could overflow
+static const unsigned int MAX_PENDING_ADDITIONS = 1u << 30;
+
+ExactSum::ExactSum()
+    : _limbs(LIMBS_NUMBER, 0), _nonFinite(0.0), _pendingAdditions(0) {}
+
+void ExactSum::add(double value) {
+  if (!std::isfinite(value)) {
+    _nonFinite += value;
+    return;
+  }
+  if (value == 0.0) {
+    return;
+  }
+  // |value| = mantissa * 2^(position + MIN_EXPONENT)
+  int exponent = 0;
+  auto fraction = std::frexp(std::fabs(value), &exponent);
+  auto mantissa = static_cast<uint64_t>(std::ldexp(fraction, MANTISSA_BITS));
+  auto position = exponent - MANTISSA_BITS - MIN_EXPONENT;
+  if (position < 0) {
+    // subnormal: the shifted out bits are zeros
+    mantissa >>= -position;
+    position = 0;
+  }
+  auto limb = static_cast<unsigned int>(position / LIMB_BITS);
+  auto shift = position % LIMB_BITS;
+  int64_t sign = (value < 0.0) ? -1 : 1;
+  _limbs[limb] += sign * static_cast<int64_t>((mantissa << shift) & LIMB_MASK);
+  auto middle = (mantissa >> (LIMB_BITS - shift)) & LIMB_MASK;
+  _limbs[limb + 1] += sign * static_cast<int64_t>(middle);
+  if (shift) {
+    _limbs[limb + 2] +=
+        sign * static_cast<int64_t>(mantissa >> (2 * LIMB_BITS - shift));
+  }
+  addPending(1);
+}
+
+void ExactSum::add(const ExactSum &other) {
+  for (unsigned int i = 0; i < LIMBS_NUMBER; ++i) {
+    _limbs[i] += other._limbs[i];
+  }
+  _nonFinite += other._nonFinite;
+  addPending(other._pendingAdditions + 1);
+}
+
+void ExactSum::parallelSum() {
+  // after the propagation, the limbs are small enough to be summed
+  // over any realistic number of ranks
+  propagateCarries(_limbs);
+  _pendingAdditions = 0;
+  ParallelContext::sumVectorInt64(_limbs);
+  ParallelContext::sumDouble(_nonFinite);
+  propagateCarries(_limbs);
+}
+
+double ExactSum::getValue() const {
+  if (_nonFinite != 0.0) {
+    // infinite or NaN
+    return _nonFinite;
+  }
+  auto limbs = _limbs;
+  propagateCarries(limbs);
+  // only the most significant limb can be negative
+  bool negative = limbs.back() < 0;
+  if (negative) {
+    for (auto &limb : limbs) {
+      limb = -limb;
+    }
+    propagateCarries(limbs);
+  }
+  int top = static_cast<int>(LIMBS_NUMBER) - 1;
+  while (top >= 0 && limbs[top] == 0) {
+    --top;
+  }
+  if (top < 0) {
+    return 0.0;
+  }
+  // four limbs hold more than the 53 bits of a double: sum them from
+  // the least significant one, each term being exactly representable
+  double res = 0.0;
+  for (int i = std::max(0, top - 3); i <= top; ++i) {
+    res += std::ldexp(static_cast<double>(limbs[i]),
+                      i * LIMB_BITS + MIN_EXPONENT);
+  }
+  return negative ? -res : res;
+}
+
+void ExactSum::addPending(unsigned int additions) {
+  _pendingAdditions += additions;
+  if (_pendingAdditions >= MAX_PENDING_ADDITIONS) {
+    propagateCarries(_limbs);
+    _pendingAdditions = 0;
+  }
+}
+
+void ExactSum::propagateCarries(std::vector<int64_t> &limbs) {
+  // move the carries up such that all limbs but the last one are
+  // in [0, 2^32)
+  for (unsigned int i = 0; i + 1 < limbs.size(); ++i) {
+    auto limb = limbs[i];
+    // floor division, to keep the remainder non-negative
+    int64_t carry = (limb >= 0) ? limb / LIMB_BASE
+                                : -((-limb + LIMB_BASE - 1) / LIMB_BASE);
+    limbs[i] = limb - carry * LIMB_BASE;
+    limbs[i + 1] += carry;
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ *  Exact accumulator for sums of doubles.
+ *
+ *  Each added value is converted without rounding to an integer
+ *  multiple of the smallest subnormal double, stored as 32 bits
+ *  limbs in 64 bits integers (fixed-point superaccumulator).
+ *  Integer additions are associative, so the final value does not
+ *  depend on the order of the additions, nor on how the values are
+ *  distributed among the parallel ranks: the same set of values
+ *  always gives bitwise-identical totals.
+ */
+class ExactSum {
+public:
+  ExactSum();
+
+  void add(double value);
+  void add(const ExactSum &other);
+  ExactSum &operator+=(double value) {
+    add(value);
+    return *this;
+  }
+
+  /**
+   *  Replace the local sum with the sum over all parallel ranks.
+   *  Must be called by all ranks
+   */
+  void parallelSum();
+
+  /**
+   *  The exact sum, rounded to a double in a deterministic way
+   */
+  double getValue() const;
+
+  /**
+   *  Order-independent sum of the local values of all parallel
+   *  ranks. Must be called by all ranks
+   */
+  template <class Container>
+  static double getParallelSum(const Container &localValues) {
+    ExactSum sum;
+    for (auto value : localValues) {
+      sum.add(value);
+    }
+    sum.parallelSum();
+    return sum.getValue();
+  }
+
+private:
+  std::vector<int64_t> _limbs;
+  // sum of the infinite and NaN values
+  double _nonFinite;
+  // number of additions since the last carry propagation
+  unsigned int _pendingAdditions;
+
+  void addPending(unsigned int additions);
+  static void propagateCarries(std::vector<int64_t> &limbs);
+};
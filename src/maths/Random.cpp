@@ -5,12 +5,25 @@
 std::mt19937_64 Random::_rng;
 std::uniform_int_distribution<int> Random::_uniint(0);
 std::uniform_real_distribution<double> Random::_uniproba(0.0, 1.0);
+unsigned int Random::_seed = 0;
+RandomStream *Random::_stream = nullptr;
 
-void Random::setSeed(unsigned int seed) { _rng.seed(seed); }
+void Random::setSeed(unsigned int seed) {
+  _rng.seed(seed);
+  _seed = seed;
+}
 
-int Random::getInt() { return _uniint(_rng); }
+int Random::getInt() {
+  if (_stream) {
+    return _stream->getInt();
+  }
+  return _uniint(_rng);
+}
 
 int Random::getInt(unsigned int min, unsigned int max) {
+  if (_stream) {
+    return _stream->getInt(min, max);
+  }
   std::uniform_int_distribution<int> distr(min, max);
   return distr(_rng);
 }
@@ -18,6 +31,9 @@ int Random::getInt(unsigned int min, unsigned int max) {
 bool Random::getBool() { return getInt() % 2; }
 
 double Random::getProba() {
+  if (_stream) {
+    return _stream->getProba();
+  }
   // sometimes produces 1.0, though should not; see the link:
   // https://en.cppreference.com/w/cpp/numeric/random/uniform_real_distribution
   double proba = _uniproba(_rng);
@@ -26,3 +42,17 @@ double Random::getProba() {
     proba = std::nextafter(1.0, 0.0);
   return proba;
 }
+
+RandomStream Random::getStream(unsigned int family, RandomPhase phase,
+                               unsigned int iteration) {
+  return RandomStream(_seed, family, phase, iteration);
+}
+
+ScopedRandomStream::ScopedRandomStream(unsigned int family, RandomPhase phase,
+                                       unsigned int iteration)
+    : _stream(Random::getStream(family, phase, iteration)),
+      _previous(Random::_stream) {
+  Random::_stream = &_stream;
+}
+
+ScopedRandomStream::~ScopedRandomStream() { Random::_stream = _previous; }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <maths/RandomStream.hpp>
 #include <random>
 
 class Random {
@@ -14,9 +15,38 @@ public:
   static bool getBool();
   // return a uniform random double from the [0,1) interval
   static double getProba();
+  // return the counter-based stream of a random decision context,
+  // keyed by the last seed set with setSeed
+  static RandomStream getStream(unsigned int family, RandomPhase phase,
+                                unsigned int iteration = 0);
 
 private:
+  friend class ScopedRandomStream;
   static std::mt19937_64 _rng;
   static std::uniform_int_distribution<int> _uniint;
   static std::uniform_real_distribution<double> _uniproba;
+  static unsigned int _seed;
+  // if set, all draws come from this stream instead of _rng
+  static RandomStream *_stream;
+};
+
+/**
+ *  While an instance is alive, the Random functions draw from the
+ *  stream of the given context, and the state of the global
+ *  generator is left untouched. Code that is not aware of streams
+ *  (tree randomization, reconciliation sampling...) then makes
+ *  decisions that only depend on their context, and not on which
+ *  rank runs them or on what this rank did before.
+ */
+class ScopedRandomStream {
+public:
+  ScopedRandomStream(unsigned int family, RandomPhase phase,
+                     unsigned int iteration = 0);
+  ~ScopedRandomStream();
+  ScopedRandomStream(const ScopedRandomStream &) = delete;
+  ScopedRandomStream &operator=(const ScopedRandomStream &) = delete;
+
+private:
+  RandomStream _stream;
+  RandomStream *_previous;
 };
@@ -0,0 +1,61 @@
+#include "RandomStream.hpp"
+
+// Philox4x32 constants, from Salmon et al. (2011), "Parallel random
+// numbers: as easy as 1, 2, 3"
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+static const unsigned int PHILOX_ROUNDS = 10;
+
+RandomStream::RandomStream(uint64_t seed, uint32_t family, RandomPhase phase,
+                           uint32_t iteration)
+    : _key({static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}),
+      _counter({family, static_cast<uint32_t>(phase), iteration, 0}),
+      _block(), _used(4) {}
+
+uint32_t RandomStream::getUInt32() {
+  if (_used == _block.size()) {
+    generateBlock();
+  }
+  return _block[_used++];
+}
+
+int RandomStream::getInt() { return static_cast<int>(getUInt32() >> 1); }
+
+int RandomStream::getInt(unsigned int min, unsigned int max) {
+  uint64_t range = uint64_t(max) - uint64_t(min) + 1;
+  // rejection sampling, to avoid the modulo bias
+  uint64_t limit = (uint64_t(1) << 32) - ((uint64_t(1) << 32) % range);
+  uint64_t value = 0;
+  do {
+    value = getUInt32();
+  } while (value >= limit);
+  return static_cast<int>(min + value % range);
+}
+
+bool RandomStream::getBool() { return getUInt32() & 1; }
+
+double RandomStream::getProba() {
+  // 53 random bits, such that the result is never 1.0
+  uint64_t bits = (uint64_t(getUInt32()) << 32) | getUInt32();
+  return static_cast<double>(bits >> 11) * (1.0 / double(uint64_t(1) << 53));
+}
+
+void RandomStream::generateBlock() {
+  auto c = _counter;
+  auto k = _key;
+  for (unsigned int round = 0; round < PHILOX_ROUNDS; ++round) {
+    uint64_t p0 = uint64_t(PHILOX_M0) * c[0];
+    uint64_t p1 = uint64_t(PHILOX_M1) * c[2];
+    c = {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+         static_cast<uint32_t>(p1),
+         static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+         static_cast<uint32_t>(p0)};
+    k[0] += PHILOX_W0;
+    k[1] += PHILOX_W1;
+  }
+  _block = c;
+  _used = 0;
+  _counter[3]++;
+}
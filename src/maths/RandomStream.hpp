@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ *  Independent random decision contexts. Each phase has its own
+ *  streams, so that adding random draws to one phase does not
+ *  change the numbers drawn by the others
+ */
+enum class RandomPhase : uint32_t {
+  BOOTSTRAP,
+  DATING_RESTARTS,
+  RECONCILIATION_SAMPLING
+};
+
+/**
+ *  Counter-based random number generator (Philox4x32-10).
+ *
+ *  The numbers are a pure function of (seed, family, phase,
+ *  iteration) and of the position in the stream: they do not depend
+ *  on which rank draws them, nor on what was drawn before in other
+ *  streams, so no synchronization between ranks is needed.
+ *  The family can be any work unit index (gene family, restart...).
+ */
+class RandomStream {
+public:
+  RandomStream(uint64_t seed, uint32_t family, RandomPhase phase,
+               uint32_t iteration = 0);
+
+  uint32_t getUInt32();
+  // return a non-negative random int
+  int getInt();
+  // return a uniform random int from the [min,max] interval
+  int getInt(unsigned int min, unsigned int max);
+  // return a random bool
+  bool getBool();
+  // return a uniform random double from the [0,1) interval
+  double getProba();
+
+private:
+  std::array<uint32_t, 2> _key;
+  // the last word is the block index within the stream
+  std::array<uint32_t, 4> _counter;
+  std::array<uint32_t, 4> _block;
+  unsigned int _used;
+
+  void generateBlock();
+};
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <likelihoods/ReconciliationEvaluation.hpp>
 #include <limits>
+#include <maths/ExactSum.hpp>
 #include <optimizers/DTLOptimizer.hpp>
 #include <parallelization/ParallelContext.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
@@ -240,12 +241,13 @@ public:
       : _evaluations(evaluations) {}
   virtual double evaluate(Parameters &parameters) {
     parameters.ensurePositivity();
-    double ll = 0.0;
+    ExactSum sumLL;
     for (auto evaluation : _evaluations) {
       evaluation->setRates(parameters);
-      ll += evaluation->evaluate();
+      sumLL.add(evaluation->evaluate());
     }
-    ParallelContext::sumDouble(ll);
+    sumLL.parallelSum();
+    double ll = sumLL.getValue();
     if (!isValidLikelihood(ll)) {
       ll = -std::numeric_limits<double>::infinity();
     }
@@ -0,0 +1,125 @@
+#include "MultiStartSpeciesTreeOptimizer.hpp"
+
+#include <IO/FileSystem.hpp>
+#include <IO/Logger.hpp>
+#include <algorithm>
+#include <cassert>
+#include <maths/Random.hpp>
+#include <memory>
+#include <parallelization/ParallelContext.hpp>
+#include <util/Paths.hpp>
+
+static std::string getGroupDir(const std::string &outputDir,
+                               unsigned int group) {
+  return FileSystem::joinPaths(outputDir, "group_" + std::to_string(group));
+}
+
+// one file per round, such that a group never overwrites a tree
+// that another group might still be reading
+static std::string getRoundTreePath(const std::string &outputDir,
+                                    unsigned int group, unsigned int round) {
+  return Paths::getSpeciesTreeFile(getGroupDir(outputDir, group),
+                                   "round_" + std::to_string(round) +
+                                       ".newick");
+}
+
+double MultiStartSpeciesTreeOptimizer::optimize(
+    const std::vector<std::string> &startingTrees, const Families &families,
+    const RecModelInfo &recModelInfo, const Parameters &startingRates,
+    bool userDTLRates, const std::string &outputDir,
+    const SpeciesTreeSearchParams &searchParams,
+    SpeciesSearchStrategy strategy) {
+  assert(startingTrees.size());
+  // each group gets its own seed, derived from a value drawn by all
+  // ranks, and the consistent random state is restored at the end
+  auto consistentSeed = static_cast<unsigned int>(Random::getInt());
+  auto groups = std::max(
+      1u, std::min(searchParams.multiStartGroups, ParallelContext::getSize()));
+  auto rounds = std::max(1u, searchParams.multiStartRounds);
+  Logger::timed << "[Multi-start search] " << groups << " groups, " << rounds
+                << " rounds" << std::endl;
+  for (unsigned int g = 0; g < groups; ++g) {
+    FileSystem::mkdir(getGroupDir(outputDir, g), true);
+    FileSystem::mkdir(Paths::getSpeciesTreesDir(getGroupDir(outputDir, g)),
+                      true);
+  }
+  ParallelContext::barrier();
+  auto group = ParallelContext::pushGroupContext(groups);
+  // only the first group (which contains the master rank) logs
+  Logger::setContextSilent(group != 0);
+  Random::setSeed(consistentSeed + group + 1);
+  auto groupDir = getGroupDir(outputDir, group);
+  // starting all groups from the same tree would waste the
+  // surplus groups on nearly identical trajectories
+  auto startingTree =
+      group < startingTrees.size() ? startingTrees[group] : "random";
+  // the families are distributed among the ranks of the group
+  auto optimizer = std::make_unique<SpeciesTreeOptimizer>(
+      startingTree, families, recModelInfo, startingRates, userDTLRates,
+      groupDir, searchParams);
+  double bestLL = 0.0;
+  unsigned int bestGroup = 0;
+  for (unsigned int round = 0; round < rounds; ++round) {
+    optimizer->optimize(strategy);
+    double ll = optimizer->computeRecLikelihood();
+    optimizer->saveCurrentSpeciesTreePath(
+        getRoundTreePath(outputDir, group, round));
+    // per-family rates are indexed by the local families of each
+    // group, so only global rates are exchanged
+    auto rates = optimizer->getModelRates().rates;
+    // compare the groups. All the ranks of a group have the same
+    // likelihood, ties are broken by the lowest rank
+    ParallelContext::pushParentContext();
+    std::vector<double> allLLs;
+    std::vector<unsigned int> allGroups;
+    ParallelContext::allGatherDouble(ll, allLLs);
+    ParallelContext::allGatherUInt(group, allGroups);
+    unsigned int bestRank = 0;
+    unsigned int worstRank = 0;
+    for (unsigned int i = 0; i < allLLs.size(); ++i) {
+      if (allLLs[i] > allLLs[bestRank]) {
+        bestRank = i;
+      }
+      if (allLLs[i] < allLLs[worstRank]) {
+        worstRank = i;
+      }
+    }
+    if (!recModelInfo.perFamilyRates) {
+      for (unsigned int i = 0; i < rates.dimensions(); ++i) {
+        ParallelContext::broadcastDouble(bestRank, rates[i]);
+      }
+    }
+    bestLL = allLLs[bestRank];
+    bestGroup = allGroups[bestRank];
+    auto worstGroup = allGroups[worstRank];
+    // logged from the parent context: only the master rank prints
+    Logger::timed << "[Multi-start search] End of round " << round
+                  << ": best ll=" << bestLL << " (group " << bestGroup
+                  << "), worst ll=" << allLLs[worstRank] << " (group "
+                  << worstGroup << ")" << std::endl;
+    ParallelContext::popContext();
+    bool lastRound = (round + 1 == rounds);
+    if (!lastRound && group == worstGroup && worstGroup != bestGroup) {
+      // restart the worst group from the incumbent
+      auto incumbentRates =
+          recModelInfo.perFamilyRates ? startingRates : rates;
+      // same families and context: reuse the loaded conditional clades
+      auto ccps = optimizer->getConditionalClades();
+      optimizer.reset();
+      optimizer = std::make_unique<SpeciesTreeOptimizer>(
+          getRoundTreePath(outputDir, bestGroup, round), families,
+          recModelInfo, incumbentRates, userDTLRates, groupDir,
+          searchParams, ccps);
+    }
+  }
+  if (group == bestGroup) {
+    optimizer->saveCurrentSpeciesTreePath(
+        Paths::getSpeciesTreeFile(outputDir, "inferred_species_tree.newick"));
+  }
+  optimizer.reset();
+  ParallelContext::popContext();
+  Logger::setContextSilent(false);
+  ParallelContext::barrier();
+  Random::setSeed(consistentSeed);
+  return bestLL;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <optimizers/SpeciesTreeOptimizer.hpp>
+#include <string>
+#include <vector>
+
+/**
+ *  Multi-start species tree search.
+ *
+ *  The ranks are split into searchParams.multiStartGroups groups of
+ *  contiguous ranks. Each group distributes all the families among
+ *  its own ranks, and runs a complete SpeciesTreeOptimizer search
+ *  from its own starting tree and random seed. After each of the
+ *  searchParams.multiStartRounds rounds, the groups compare their
+ *  likelihoods: the worst group restarts from the best tree and
+ *  rates found so far, while the other groups continue their own
+ *  trajectory, which keeps the searches diverse.
+ *
+ *  When per-core family parallelism saturates, this turns the
+ *  surplus ranks into independent searches instead of idle time in
+ *  the collectives.
+ */
+class MultiStartSpeciesTreeOptimizer {
+public:
+  MultiStartSpeciesTreeOptimizer() = delete;
+
+  /**
+   *  Must be called by all ranks. The best species tree is saved to
+   *  the inferred_species_tree.newick file of outputDir, and each
+   *  group writes its own files into a group_<index> subdirectory.
+   *  @param startingTrees starting species tree of each group (path
+   *         or "random"). The groups beyond startingTrees.size()
+   *         start from a random tree drawn with their own seed
+   *  @return the reconciliation likelihood of the best tree
+   */
+  static double optimize(const std::vector<std::string> &startingTrees,
+                         const Families &families,
+                         const RecModelInfo &recModelInfo,
+                         const Parameters &startingRates, bool userDTLRates,
+                         const std::string &outputDir,
+                         const SpeciesTreeSearchParams &searchParams,
+                         SpeciesSearchStrategy strategy);
+};
@@ -2,7 +2,13 @@
 
 #include "DTLOptimizer.hpp"
 #include <IO/FileSystem.hpp>
+#include <IO/LibpllException.hpp>
+#include <IO/PerFamilyLikelihoodStream.hpp>
 #include <algorithm>
+#include <ccp/ConditionalClades.hpp>
+#include <likelihoods/EvaluationMemoryManager.hpp>
+#include <maths/ExactSum.hpp>
+#include <unordered_set>
 #include <cstdio>
 #include <fstream>
 #include <routines/Routines.hpp>
@@ -26,10 +32,14 @@ SpeciesTreeOptimizer::SpeciesTreeOptimizer(
     const std::string speciesTreeFile, const Families &initialFamilies,
     const RecModelInfo &recModelInfo, const Parameters &startingRates,
     bool userDTLRates, const std::string &outputDir,
-    const SpeciesTreeSearchParams &searchParams)
+    const SpeciesTreeSearchParams &searchParams, const PerCoreCCPs &ccps)
     : _speciesTree(makeSpeciesTree(speciesTreeFile, initialFamilies,
                                    recModelInfo.isDated())),
-      _geneTrees(std::make_unique<PerCoreGeneTrees>(initialFamilies, true)),
+      // in amalgamated mode, the gene trees of a family are summarized
+      // in its CCP: we only keep one starting tree per family
+      _geneTrees(std::make_unique<PerCoreGeneTrees>(
+          initialFamilies, !recModelInfo.amalgamatedGeneTrees)),
+      _ccps(ccps),
       _initialFamilies(initialFamilies), _outputDir(outputDir),
       _firstOptimizeRatesCall(true), _userDTLRates(userDTLRates),
       _modelRates(startingRates, 1, recModelInfo), _searchParams(searchParams),
@@ -111,6 +121,7 @@ void SpeciesTreeOptimizer::optimize(SpeciesSearchStrategy strategy) {
   case SpeciesSearchStrategy::SKIP:
     assert(false);
   }
+  _searchState.flushBestSpeciesTree();
 }
 
 SpeciesTreeOptimizer::~SpeciesTreeOptimizer() {
@@ -119,32 +130,34 @@ SpeciesTreeOptimizer::~SpeciesTreeOptimizer() {
 
 double SpeciesTreeOptimizer::rootSearch(unsigned int maxDepth,
                                         bool outputConsel) {
-  TreePerFamLLVec treePerFamLLVec;
+  std::unique_ptr<PerFamilyLikelihoodStream> perFamLLStream;
+  if (outputConsel) {
+    std::string treesOutput = Paths::getConselTreeList(_outputDir, "roots");
+    std::string llOutput = Paths::getConselLikelihoods(_outputDir, "roots");
+    perFamLLStream = std::make_unique<PerFamilyLikelihoodStream>(
+        _evaluations.size(), treesOutput, llOutput);
+  }
   RootLikelihoods rootLikelihoods(_evaluations.size());
   Logger::info << std::endl;
   SpeciesRootSearch::rootSearch(*_speciesTree, _evaluator, _searchState,
                                 maxDepth, &rootLikelihoods,
-                                (outputConsel ? &treePerFamLLVec : nullptr));
+                                perFamLLStream.get());
   saveCurrentSpeciesTreeId();
   {
-    auto newick = _speciesTree->getTree().getNewickString();
-    PLLRootedTree tree(newick, false);
-    rootLikelihoods.fillTree(tree);
+    auto tree = _speciesTree->getTree().clone();
+    rootLikelihoods.fillTree(*tree);
     auto out = Paths::getSpeciesTreeFile(_outputDir, "species_tree_llr.newick");
-    tree.save(out);
+    tree->save(out);
   }
   {
-    auto newick = _speciesTree->getTree().getNewickString();
-    PLLRootedTree tree(newick, false);
-    rootLikelihoods.fillTreeBootstraps(tree);
+    auto tree = _speciesTree->getTree().clone();
+    rootLikelihoods.fillTreeBootstraps(*tree);
     auto out = Paths::getSpeciesTreeFile(_outputDir,
                                          "species_tree_root_support.newick");
-    tree.save(out);
+    tree->save(out);
   }
-  if (outputConsel) {
-    std::string treesOutput = Paths::getConselTreeList(_outputDir, "roots");
-    std::string llOutput = Paths::getConselLikelihoods(_outputDir, "roots");
-    savePerFamilyLikelihoods(treePerFamLLVec, treesOutput, llOutput);
+  if (perFamLLStream) {
+    perFamLLStream->finalize();
   }
   auto ll = computeRecLikelihood();
   return ll;
@@ -194,27 +207,63 @@ double SpeciesTreeOptimizer::computeRecLikelihood() {
   return _evaluator.computeLikelihood();
 }
 
+/**
+ *  Read the conditional clades of a family from its ccp file, or
+ *  build them from the gene trees of its starting gene tree file
+ */
+static std::shared_ptr<const ConditionalClades>
+loadConditionalClades(const FamilyInfo &family) {
+  auto ccp = std::make_shared<ConditionalClades>();
+  if (family.ccpFile.size()) {
+    ccp->unserialize(family.ccpFile);
+  } else {
+    *ccp = ConditionalClades(family.startingGeneTree, family.likelihoodFile,
+                             CCPRooting::UNIFORM);
+  }
+  if (!ccp->isValid()) {
+    throw LibpllException("Invalid conditional clades for family ",
+                          family.name);
+  }
+  return ccp;
+}
+
 void SpeciesTreeOptimizer::updateEvaluations() {
   assert(_geneTrees);
   auto &trees = _geneTrees->getTrees();
   _evaluations.resize(trees.size());
+  if (_modelRates.info.amalgamatedGeneTrees) {
+    _ccps.resize(trees.size());
+  }
+  auto memoryManager =
+      EvaluationMemoryManager::create(_modelRates.info.memoryBudget);
   for (unsigned int i = 0; i < trees.size(); ++i) {
     auto &tree = trees[i];
-    std::string enforcedRootedGeneTree;
-    if (_modelRates.info.forceGeneTreeRoot) {
-      enforcedRootedGeneTree = tree.startingGeneTreeFile;
+    if (_modelRates.info.amalgamatedGeneTrees) {
+      if (!_ccps[i]) {
+        _ccps[i] = loadConditionalClades(_initialFamilies[tree.familyIndex]);
+      }
+      _evaluations[i] = std::make_shared<ReconciliationEvaluation>(
+          _speciesTree->getTree(), _ccps[i], tree.mapping, _modelRates.info);
+    } else {
+      std::string enforcedRootedGeneTree;
+      if (_modelRates.info.forceGeneTreeRoot) {
+        enforcedRootedGeneTree = tree.startingGeneTreeFile;
+      }
+      _evaluations[i] = std::make_shared<ReconciliationEvaluation>(
+          _speciesTree->getTree(), *tree.geneTree, tree.mapping,
+          _modelRates.info, enforcedRootedGeneTree);
     }
-    _evaluations[i] = std::make_shared<ReconciliationEvaluation>(
-        _speciesTree->getTree(), *tree.geneTree, tree.mapping, _modelRates.info,
-        enforcedRootedGeneTree);
+    // register before the next family is built, to keep the peak
+    // memory within the budget
+    _evaluations[i]->setMemoryManager(memoryManager);
     _evaluations[i]->setRates(_modelRates.getRates(i));
     _evaluations[i]->setPartialLikelihoodMode(
         PartialLikelihoodMode::PartialSpecies);
   }
   _previousGeneRoots.resize(_evaluations.size());
   std::fill(_previousGeneRoots.begin(), _previousGeneRoots.end(), nullptr);
-  _evaluator.init(_evaluations, *_geneTrees, _modelRates,
-                  _modelRates.info.rootedGeneTree,
+  _evaluator.init(_speciesTree->getTree(), _evaluations, *_geneTrees,
+                  _modelRates, _modelRates.info.rootedGeneTree,
                   _modelRates.info.pruneSpeciesTree, _userDTLRates);
 }
 
@@ -231,6 +280,11 @@ void SpeciesTreeOptimizer::onSpeciesTreeChange(
   }
 }
 
+void SpeciesTreeOptimizer::onChange(const SpeciesTreeChange &change) {
+  _evaluator.onSpeciesTreeChange(change);
+  SpeciesTree::Listener::onChange(change);
+}
+
 std::string getCladesSetPath(const std::string &outputDir, int rank) {
   std::string basePath = "clades_" + std::to_string(rank) + ".txt";
   return FileSystem::joinPaths(outputDir, basePath);
@@ -286,62 +340,206 @@ static std::string getSubtreeID(corax_rnode_t *subtree) {
   return std::string("(") + id1 + "," + id2 + ")";
 }
 
-void SpeciesTreeOptimizer::savePerFamilyLikelihoods(
-    const TreePerFamLLVec &treePerFamLLVec, const std::string &treesOutput,
-    const std::string &llOutput) {
-  ParallelContext::barrier();
-  if (ParallelContext::getRank() == 0 && treePerFamLLVec.size() != 0) {
-    std::ofstream osLL(llOutput);
-    std::ofstream osTrees(treesOutput);
-    auto treesNumber = treePerFamLLVec.size();
-    auto familiesNumber = treePerFamLLVec[0].second.size();
-    osLL << treesNumber << " " << familiesNumber << std::endl;
-    unsigned int index = 1;
-    for (const auto &treePerFamLL : treePerFamLLVec) {
-      const auto &tree = treePerFamLL.first;
-      const auto perFamLL = treePerFamLL.second;
-      std::string treeName = "tree";
-      treeName += std::to_string(index++);
-      osTrees << tree << std::endl;
-      osLL << treeName;
-      for (auto ll : perFamLL) {
-        osLL << " " << ll;
+void SpeciesTreeLikelihoodEvaluator::init(
+    const PLLRootedTree &speciesTree, PerCoreEvaluations &evaluations,
+    PerCoreGeneTrees &geneTrees, ModelParameters &modelRates,
+    bool rootedGeneTrees, bool pruneSpeciesTree, bool userDTLRates) {
+  _speciesTree = &speciesTree;
+  _evaluations = &evaluations;
+  _geneTrees = &geneTrees;
+  _modelRates = &modelRates;
+  _rootedGeneTrees = rootedGeneTrees;
+  _pruneSpeciesTree = pruneSpeciesTree;
+  _userDTLRates = userDTLRates;
+  _skipUnaffectedFamilies =
+      pruneSpeciesTree && !modelRates.info.isDated() &&
+      !Enums::accountsForTransfers(modelRates.info.model);
+  _coveredSpecies.clear();
+  if (_skipUnaffectedFamilies) {
+    auto labelToId = speciesTree.getLeafLabelToId();
+    for (auto &tree : geneTrees.getTrees()) {
+      std::unordered_set<unsigned int> covered;
+      for (const auto &p : tree.mapping.getMap()) {
+        auto it = labelToId.find(p.second);
+        if (it != labelToId.end()) {
+          covered.insert(it->second);
+        }
       }
-      osLL << std::endl;
+      _coveredSpecies.push_back(
+          std::vector<unsigned int>(covered.begin(), covered.end()));
     }
   }
-  ParallelContext::barrier();
+  _upToDate.assign(evaluations.size(), false);
+  _cachedLL.assign(evaluations.size(), 0.0);
 }
 
-double SpeciesTreeLikelihoodEvaluator::computeLikelihood(PerFamLL *perFamLL) {
-  if (_rootedGeneTrees) {
-    for (auto evaluation : *_evaluations) {
-      evaluation->setRoot(nullptr);
-    }
+double SpeciesTreeLikelihoodEvaluator::evaluateFamily(unsigned int family,
+                                                      bool resetRoot) {
+  if (_upToDate[family]) {
+    return _cachedLL[family];
+  }
+  auto &evaluation = (*_evaluations)[family];
+  if (resetRoot) {
+    evaluation->setRoot(nullptr);
+  }
+  auto ll = evaluation->evaluate();
+  // with rooted gene trees, the fast likelihood keeps the previous
+  // gene roots and is only a lower bound: it must not be returned by
+  // a later computeLikelihood call
+  if (resetRoot || !_rootedGeneTrees) {
+    _cachedLL[family] = ll;
+    _upToDate[family] = _skipUnaffectedFamilies;
   }
+  return ll;
+}
+
+double SpeciesTreeLikelihoodEvaluator::computeLikelihood(PerFamLL *perFamLL) {
   if (perFamLL) {
     perFamLL->clear();
   }
-  double sumLL = 0.0;
-  for (auto &evaluation : *_evaluations) {
-    auto ll = evaluation->evaluate();
+  // exact sum: the total does not depend on the number of ranks
+  ExactSum sumLL;
+  for (unsigned int i = 0; i < _evaluations->size(); ++i) {
+    auto ll = evaluateFamily(i, _rootedGeneTrees);
     if (perFamLL) {
       perFamLL->push_back(ll);
     }
-    sumLL += ll;
+    sumLL.add(ll);
   }
-  ParallelContext::sumDouble(sumLL);
-  return sumLL;
+  sumLL.parallelSum();
+  return sumLL.getValue();
 }
 
 double SpeciesTreeLikelihoodEvaluator::computeLikelihoodFast() {
-  double sumLL = 0.0;
-  for (auto &evaluation : *_evaluations) {
-    auto ll = evaluation->evaluate();
-    sumLL += ll;
+  ExactSum sumLL;
+  for (unsigned int i = 0; i < _evaluations->size(); ++i) {
+    sumLL.add(evaluateFamily(i, false));
+  }
+  sumLL.parallelSum();
+  return sumLL.getValue();
+}
+
+void SpeciesTreeLikelihoodEvaluator::invalidateAllFamilies() {
+  std::fill(_upToDate.begin(), _upToDate.end(), false);
+}
+
+/**
+ *  Positions of the species leaves in a depth-first traversal, such
+ *  that the leaves under each node form the interval [begin, end[
+ */
+struct LeafIntervals {
+  LeafIntervals(const PLLRootedTree &tree)
+      : position(tree.getNodeNumber()), begin(tree.getNodeNumber()),
+        end(tree.getNodeNumber()) {
+    unsigned int leaves = 0;
+    for (auto node : tree.getPostOrderNodes()) {
+      auto e = node->node_index;
+      if (!node->left) {
+        position[e] = begin[e] = leaves++;
+        end[e] = leaves;
+      } else {
+        begin[e] = begin[node->left->node_index];
+        end[e] = end[node->right->node_index];
+      }
+    }
+  }
+  bool contains(const corax_rnode_t *node, unsigned int pos) const {
+    auto e = node->node_index;
+    return begin[e] <= pos && pos < end[e];
+  }
+  std::vector<unsigned int> position;
+  std::vector<unsigned int> begin;
+  std::vector<unsigned int> end;
+};
+
+/**
+ *  Return the lowest ancestor (or self) of node that covers at least
+ *  one of the sorted leaf positions, and set count to the number of
+ *  positions it covers
+ */
+static const corax_rnode_t *
+getLowestCoveringAncestor(const corax_rnode_t *node,
+                          const LeafIntervals &intervals,
+                          const std::vector<unsigned int> &positions,
+                          unsigned int &count) {
+  while (true) {
+    auto e = node->node_index;
+    auto first = std::lower_bound(positions.begin(), positions.end(),
+                                  intervals.begin[e]);
+    auto last =
+        std::lower_bound(positions.begin(), positions.end(), intervals.end[e]);
+    count = static_cast<unsigned int>(last - first);
+    if (count || !node->parent) {
+      return node;
+    }
+    node = node->parent;
+  }
+}
+
+/**
+ *  Return true if the tree induced by the covered species is the
+ *  same before and after the SPR move described in change.
+ *
+ *  Let C be the covered species, P the pruned subtree and C' = C \ P.
+ *  If C' is empty or if P has no covered species, the induced tree
+ *  cannot change. Otherwise, the induced tree only depends on where
+ *  P attaches in the tree induced by C', which is given by the set of
+ *  C' species under the lowest ancestor of the sibling of P that
+ *  covers C' species.
+ *  Two such sets are either nested or disjoint, so comparing their
+ *  sizes and checking that they overlap is enough.
+ */
+static bool isInducedTreeUnchanged(const std::vector<unsigned int> &covered,
+                                   const LeafIntervals &intervals,
+                                   const SpeciesTreeChange &change,
+                                   std::vector<unsigned int> &positions) {
+  bool coversPrune = false;
+  positions.clear();
+  for (auto species : covered) {
+    auto pos = intervals.position[species];
+    if (intervals.contains(change.sprPrune, pos)) {
+      coversPrune = true;
+    } else {
+      positions.push_back(pos);
+    }
+  }
+  if (!coversPrune || positions.empty()) {
+    return true;
+  }
+  std::sort(positions.begin(), positions.end());
+  unsigned int oldCount = 0;
+  unsigned int newCount = 0;
+  auto oldSibling = getLowestCoveringAncestor(change.sprOldBrother, intervals,
+                                              positions, oldCount);
+  auto newSibling = getLowestCoveringAncestor(change.sprNewBrother, intervals,
+                                              positions, newCount);
+  auto e1 = oldSibling->node_index;
+  auto e2 = newSibling->node_index;
+  bool overlap = intervals.begin[e1] < intervals.end[e2] &&
+                 intervals.begin[e2] < intervals.end[e1];
+  return oldCount == newCount && overlap;
+}
+
+void SpeciesTreeLikelihoodEvaluator::onSpeciesTreeChange(
+    const SpeciesTreeChange &change) {
+  if (change.dates) {
+    invalidateAllFamilies();
+  }
+  if (!change.topology) {
+    return;
+  }
+  if (!_skipUnaffectedFamilies || !change.isSingleSPR()) {
+    invalidateAllFamilies();
+    return;
+  }
+  LeafIntervals intervals(*_speciesTree);
+  std::vector<unsigned int> positions;
+  for (unsigned int i = 0; i < _upToDate.size(); ++i) {
+    if (_upToDate[i] && !isInducedTreeUnchanged(_coveredSpecies[i], intervals,
+                                                 change, positions)) {
+      _upToDate[i] = false;
+    }
   }
-  ParallelContext::sumDouble(sumLL);
-  return sumLL;
 }
 
 bool SpeciesTreeLikelihoodEvaluator::providesFastLikelihoodImpl() const {
@@ -368,6 +566,7 @@ double SpeciesTreeLikelihoodEvaluator::optimizeModelRates(bool thorough) {
   for (auto &evaluation : *_evaluations) {
     evaluation->setRates(_modelRates->getRates(i++));
   }
+  invalidateAllFamilies();
   if (!_modelRates->info.perFamilyRates) {
     Logger::timed << "[Species search] Best rates: " << _modelRates->rates
                   << std::endl;
@@ -402,7 +601,11 @@ void SpeciesTreeLikelihoodEvaluator::pushRollback() {
 void SpeciesTreeLikelihoodEvaluator::popAndApplyRollback() {
   if (_rootedGeneTrees) {
     for (unsigned int i = 0; i < _evaluations->size(); ++i) {
-      (*_evaluations)[i]->setRoot(_previousGeneRoots.top()[i]);
+      auto root = _previousGeneRoots.top()[i];
+      if ((*_evaluations)[i]->getRoot() != root) {
+        (*_evaluations)[i]->setRoot(root);
+        _upToDate[i] = false;
+      }
     }
     _previousGeneRoots.pop();
   }
@@ -32,10 +32,17 @@ struct SpeciesTreeSearchParams {
   SpeciesTreeSearchParams()
       : sprRadius(DEFAULT_SPECIES_SPR_RADIUS),
         rootSmallRadius(DEFAULT_SPECIES_SMALL_ROOT_RADIUS),
-        rootBigRadius(DEFAULT_SPECIES_BIG_ROOT_RADIUS) {}
+        rootBigRadius(DEFAULT_SPECIES_BIG_ROOT_RADIUS), multiStartGroups(1),
+        multiStartRounds(1) {}
   unsigned int sprRadius;
   unsigned int rootSmallRadius;
   unsigned int rootBigRadius;
+  // number of independent searches run by groups of ranks
+  // (see MultiStartSpeciesTreeOptimizer)
+  unsigned int multiStartGroups;
+  // number of search rounds, after which the groups exchange
+  // their best tree and rates
+  unsigned int multiStartRounds;
 };
 
 struct MovesBlackList;
@@ -44,16 +51,9 @@ class SpeciesTreeLikelihoodEvaluator
     : public SpeciesTreeLikelihoodEvaluatorInterface {
 public:
   SpeciesTreeLikelihoodEvaluator() {}
-  void init(PerCoreEvaluations &evaluations, PerCoreGeneTrees &geneTrees,
-            ModelParameters &modelRates, bool rootedGeneTrees,
-            bool pruneSpeciesTree, bool userDTLRates) {
-    _evaluations = &evaluations;
-    _geneTrees = &geneTrees;
-    _modelRates = &modelRates;
-    _rootedGeneTrees = rootedGeneTrees;
-    _pruneSpeciesTree = pruneSpeciesTree;
-    _userDTLRates = userDTLRates;
-  }
+  void init(const PLLRootedTree &speciesTree, PerCoreEvaluations &evaluations,
+            PerCoreGeneTrees &geneTrees, ModelParameters &modelRates,
+            bool rootedGeneTrees, bool pruneSpeciesTree, bool userDTLRates);
   virtual ~SpeciesTreeLikelihoodEvaluator() {}
   virtual double computeLikelihood(PerFamLL *perFamLL = nullptr);
   virtual double computeLikelihoodFast();
@@ -69,7 +69,22 @@ public:
                          PerCorePotentialTransfers &potentialTransfers);
   virtual bool pruneSpeciesTree() const { return _pruneSpeciesTree; }
 
+  /**
+   *  Must be called on each species tree change: decide which
+   *  families have to be evaluated again. Families whose induced
+   *  species tree is not affected by a SPR move keep their likelihood
+   */
+  void onSpeciesTreeChange(const SpeciesTreeChange &change);
+
+  /**
+   *  Evaluate all families on the next likelihood computation
+   */
+  void invalidateAllFamilies();
+
 private:
+  double evaluateFamily(unsigned int family, bool resetRoot);
+
+  const PLLRootedTree *_speciesTree;
   PerCoreGeneTrees *_geneTrees;
   PerCoreEvaluations *_evaluations;
   ModelParameters *_modelRates;
@@ -77,16 +92,32 @@ private:
   bool _rootedGeneTrees;
   bool _pruneSpeciesTree;
   bool _userDTLRates;
+  // true if the likelihood of a family only depends on the species
+  // tree induced by its covered species (pruned mode without transfers)
+  bool _skipUnaffectedFamilies;
+  // per family: indices of the covered species leaves
+  std::vector<std::vector<unsigned int>> _coveredSpecies;
+  // per family: true if _cachedLL is the current likelihood, as
+  // computed by computeLikelihood
+  std::vector<bool> _upToDate;
+  std::vector<double> _cachedLL;
 };
 
 class SpeciesTreeOptimizer : public SpeciesTree::Listener {
 public:
+  /**
+   *  @param ccps in amalgamated mode, the conditional clades of the
+   *         local families, as returned by getConditionalClades of an
+   *         optimizer built with the same families in the same
+   *         parallel context. They are loaded if empty.
+   */
   SpeciesTreeOptimizer(const std::string speciesTreeFile,
                        const Families &initialFamilies,
                        const RecModelInfo &recModelInfo,
                        const Parameters &startingRates, bool userDTLRates,
                        const std::string &outputDir,
-                       const SpeciesTreeSearchParams &searchParams);
+                       const SpeciesTreeSearchParams &searchParams,
+                       const PerCoreCCPs &ccps = PerCoreCCPs());
 
   // forbid copy
   SpeciesTreeOptimizer(const SpeciesTreeOptimizer &) = delete;
@@ -98,6 +129,7 @@ public:
   virtual void onSpeciesDatesChange();
   virtual void onSpeciesTreeChange(
       const std::unordered_set<corax_rnode_t *> *nodesToInvalidate);
+  virtual void onChange(const SpeciesTreeChange &change);
 
   void optimize(SpeciesSearchStrategy strategy);
 
@@ -111,17 +143,17 @@ public:
   const SpeciesTree &getSpeciesTree() const { return *_speciesTree; }
 
   double getReconciliationLikelihood() const { return _searchState.bestLL; }
+  const ModelParameters &getModelRates() const { return _modelRates; }
+  const PerCoreCCPs &getConditionalClades() const { return _ccps; }
 
   double computeRecLikelihood();
 
-  void savePerFamilyLikelihoods(const TreePerFamLLVec &treePerFamLLVec,
-                                const std::string &treesOutput,
-                                const std::string &llOutput);
-
 private:
   std::unique_ptr<SpeciesTree> _speciesTree;
   std::unique_ptr<PerCoreGeneTrees> _geneTrees;
   PerCoreEvaluations _evaluations;
+  // amalgamated mode: loaded once, shared by the successive evaluations
+  PerCoreCCPs _ccps;
   SpeciesTreeLikelihoodEvaluator _evaluator;
   std::vector<corax_unode_t *> _previousGeneRoots;
   Families _initialFamilies;
@@ -0,0 +1,185 @@
+#include "CostModel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <parallelization/ParallelContext.hpp>
+
+std::array<CostModel::Sums, static_cast<size_t>(CostPhase::Count)>
+    CostModel::_localSums = {};
+std::array<CostModel::Sums, static_cast<size_t>(CostPhase::Count)>
+    CostModel::_globalSums = {};
+const char *const CostModel::elapsedKey = "Elapsed = ";
+
+static double known(unsigned int feature) {
+  return feature ? static_cast<double>(feature) : 1.0;
+}
+
+double CostModel::getComplexity(CostPhase phase,
+                                const FamilyCostFeatures &features,
+                                unsigned int sprRadius) {
+  double tips = known(features.tips);
+  double species = known(features.species);
+  switch (phase) {
+  case CostPhase::Reconciliation:
+    return tips * species;
+  case CostPhase::GeneTreeSearch: {
+    // number of regraft candidates per pruned subtree grows
+    // exponentially with the radius, up to the tree size
+    double regrafts = std::min(tips, std::pow(2.0, sprRadius + 1));
+    return tips * regrafts * species;
+  }
+  case CostPhase::Libpll: {
+    double states = known(features.states);
+    return tips * known(features.patterns) * states * states;
+  }
+  case CostPhase::Count:
+    break;
+  }
+  return tips;
+}
+
+double CostModel::predict(CostPhase phase, const FamilyCostFeatures &features,
+                          unsigned int sprRadius) {
+  auto x = getComplexity(phase, features, sprRadius);
+  const auto &s = _globalSums[static_cast<size_t>(phase)];
+  auto n = s[0];
+  if (n < 2.0) {
+    return x;
+  }
+  auto denominator = n * s[3] - s[1] * s[1];
+  if (denominator <= 0.0) {
+    // all measurements have the same complexity
+    return s[2] / n;
+  }
+  auto slope = (n * s[4] - s[1] * s[2]) / denominator;
+  auto intercept = (s[2] - slope * s[1]) / n;
+  slope = std::max(slope, 0.0);
+  intercept = std::max(intercept, 0.0);
+  return intercept + slope * x;
+}
+
+void CostModel::addMeasurement(CostPhase phase,
+                               const FamilyCostFeatures &features,
+                               double seconds, unsigned int sprRadius) {
+  auto x = getComplexity(phase, features, sprRadius);
+  auto &s = _localSums[static_cast<size_t>(phase)];
+  s[0] += 1.0;
+  s[1] += x;
+  s[2] += seconds;
+  s[3] += x * x;
+  s[4] += x * seconds;
+}
+
+void CostModel::synchronize() {
+  std::vector<double> sums;
+  for (const auto &s : _localSums) {
+    sums.insert(sums.end(), s.begin(), s.end());
+  }
+  ParallelContext::sumVectorDouble(sums);
+  unsigned int k = 0;
+  for (auto &s : _globalSums) {
+    for (auto &value : s) {
+      value += sums[k++];
+    }
+  }
+  _localSums = {};
+}
+
+void CostModel::calibrate(CostPhase phase,
+                          const std::vector<FamilyCostFeatures> &features,
+                          const std::vector<std::string> &statsFiles,
+                          unsigned int sprRadius) {
+  assert(features.size() == statsFiles.size());
+  auto elems = static_cast<unsigned int>(statsFiles.size());
+  for (auto i = ParallelContext::getBegin(elems);
+       i < ParallelContext::getEnd(elems); ++i) {
+    auto seconds = readElapsed(statsFiles[i]);
+    if (seconds > 0.0) {
+      addMeasurement(phase, features[i], seconds, sprRadius);
+    }
+  }
+  synchronize();
+}
+
+double CostModel::readElapsed(const std::string &statsFile) {
+  std::ifstream is(statsFile);
+  std::string key(elapsedKey);
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.compare(0, key.size(), key) == 0) {
+      return std::atof(line.c_str() + key.size());
+    }
+  }
+  return 0.0;
+}
+
+unsigned int
+CostModel::getGeneTreeSearchCores(const FamilyCostFeatures &features,
+                                  unsigned int sprRadius) {
+  // larger radius searches evaluate more moves per round,
+  // and can thus use more cores
+  unsigned int cores = 1;
+  if (sprRadius == 1) {
+    cores = features.tips / 20;
+  } else if (sprRadius == 2) {
+    cores = features.tips / 4;
+  } else if (sprRadius >= 3) {
+    cores = features.tips;
+  }
+  return std::max(cores, 1u);
+}
+
+std::vector<unsigned int>
+CostModel::toSchedulerCosts(const std::vector<double> &costs) {
+  double minCost = 0.0;
+  for (auto cost : costs) {
+    if (cost > 0.0 && (minCost == 0.0 || cost < minCost)) {
+      minCost = cost;
+    }
+  }
+  auto maxCost = static_cast<double>(1u << 30);
+  std::vector<unsigned int> res(costs.size(), 1);
+  if (minCost == 0.0) {
+    return res;
+  }
+  for (size_t i = 0; i < costs.size(); ++i) {
+    auto scaled = std::round(costs[i] / minCost * schedulerCostUnit);
+    scaled = std::max(1.0, std::min(scaled, maxCost));
+    res[i] = static_cast<unsigned int>(scaled);
+  }
+  return res;
+}
+
+std::vector<unsigned int>
+CostModel::assignToRanks(const std::vector<double> &costs) {
+  std::vector<unsigned int> order(costs.size());
+  for (unsigned int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(
+      order.begin(), order.end(),
+      [&costs](unsigned int a, unsigned int b) { return costs[a] > costs[b]; });
+  std::vector<double> loads(ParallelContext::getSize(), 0.0);
+  std::vector<unsigned int> elementToRank(costs.size(), 0);
+  for (auto element : order) {
+    auto rank = static_cast<unsigned int>(
+        std::min_element(loads.begin(), loads.end()) - loads.begin());
+    elementToRank[element] = rank;
+    loads[rank] += costs[element];
+  }
+  return elementToRank;
+}
+
+std::vector<size_t> CostModel::getMyIndices(const std::vector<double> &costs) {
+  auto elementToRank = assignToRanks(costs);
+  std::vector<size_t> myIndices;
+  for (size_t i = 0; i < elementToRank.size(); ++i) {
+    if (elementToRank[i] == ParallelContext::getRank()) {
+      myIndices.push_back(i);
+    }
+  }
+  return myIndices;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ *  The different kinds of per-family work that we schedule
+ *  or distribute across the parallel cores
+ */
+enum class CostPhase {
+  Reconciliation = 0, // one reconciliation likelihood evaluation
+  GeneTreeSearch,     // one gene tree SPR round at a given radius
+  Libpll,             // sequence-only (libpll) tree search
+  Count
+};
+
+/**
+ *  Per-family features used to predict the cost of a phase.
+ *  Features set to 0 are considered as unknown and ignored.
+ */
+struct FamilyCostFeatures {
+  // number of gene tree tips (or of CCP clades in CCP mode)
+  unsigned int tips;
+  // number of species covered by the family
+  unsigned int species;
+  // number of distinct alignment patterns
+  unsigned int patterns;
+  // number of states of the substitution model
+  unsigned int states;
+
+  FamilyCostFeatures(unsigned int tips = 0, unsigned int species = 0,
+                     unsigned int patterns = 0, unsigned int states = 0)
+      : tips(tips), species(species), patterns(patterns), states(states) {}
+};
+
+/**
+ *  Single place where we predict the runtime of per-family work,
+ *  and distribute families across the parallel cores.
+ *
+ *  For each phase, the predicted cost is a linear function of a
+ *  complexity term computed from the features:
+ *    cost = slope * complexity + intercept
+ *  The intercept accounts for the per-family overhead. Both are
+ *  calibrated online with least squares from measured timings
+ *  (see addMeasurement and synchronize). Before any calibration,
+ *  the cost is the complexity term itself.
+ *
+ *  The calibration state is global and consistent across ranks
+ *  after each call to synchronize.
+ *
+ *  Scheduled jobs run in separate processes: they report their
+ *  duration in their stats file, on a line starting with
+ *  elapsedKey, and the master calibrates from these files
+ *  (see calibrate).
+ */
+class CostModel {
+public:
+  CostModel() = delete;
+
+  /**
+   *  Predicted cost (in seconds once calibrated) of running phase
+   *  on a family. sprRadius is only used for GeneTreeSearch.
+   */
+  static double predict(CostPhase phase, const FamilyCostFeatures &features,
+                        unsigned int sprRadius = 0);
+
+  /**
+   *  Record the measured duration (in seconds) of running phase
+   *  on a family. Measurements are local to the calling rank
+   *  until synchronize is called.
+   */
+  static void addMeasurement(CostPhase phase,
+                             const FamilyCostFeatures &features,
+                             double seconds, unsigned int sprRadius = 0);
+
+  /**
+   *  Gather the local measurements of all ranks and update the
+   *  calibration. Must be called by all ranks.
+   */
+  static void synchronize();
+
+  /**
+   *  Read the durations reported in the stats files of the jobs
+   *  of a phase (one per family, aligned with features), record
+   *  them and synchronize. Must be called by all ranks.
+   */
+  static void calibrate(CostPhase phase,
+                        const std::vector<FamilyCostFeatures> &features,
+                        const std::vector<std::string> &statsFiles,
+                        unsigned int sprRadius = 0);
+
+  /**
+   *  Duration reported in a stats file, or 0 if there is none
+   */
+  static double readElapsed(const std::string &statsFile);
+  static const char *const elapsedKey;
+
+  /**
+   *  Number of cores to request when scheduling a gene tree
+   *  search job with MPIScheduler
+   */
+  static unsigned int getGeneTreeSearchCores(const FamilyCostFeatures &features,
+                                             unsigned int sprRadius);
+
+  /**
+   *  Integer costs for MPIScheduler command files (at least 1).
+   *  The costs are scaled relative to the cheapest element, which
+   *  gets schedulerCostUnit, such that the rounding preserves their
+   *  ratios whatever the unit of the predicted costs.
+   */
+  static std::vector<unsigned int>
+  toSchedulerCosts(const std::vector<double> &costs);
+  static const unsigned int schedulerCostUnit = 100;
+
+  /**
+   *  Assign each element to a rank, such that the sum of the costs
+   *  is balanced across ranks: the most expensive elements are
+   *  assigned first, each one to the least loaded rank.
+   *  The result only depends on costs, and is thus the same on all
+   *  ranks if costs are.
+   */
+  static std::vector<unsigned int>
+  assignToRanks(const std::vector<double> &costs);
+
+  /**
+   *  Return the indices of the elements assigned to the current rank
+   *  by assignToRanks
+   */
+  static std::vector<size_t> getMyIndices(const std::vector<double> &costs);
+
+private:
+  static double getComplexity(CostPhase phase,
+                              const FamilyCostFeatures &features,
+                              unsigned int sprRadius);
+
+  /**
+   *  Running sums for the least squares fit of one phase:
+   *  n, sum(x), sum(y), sum(x^2), sum(x*y)
+   */
+  using Sums = std::array<double, 5>;
+  static std::array<Sums, static_cast<size_t>(CostPhase::Count)> _localSums;
+  static std::array<Sums, static_cast<size_t>(CostPhase::Count)> _globalSums;
+};
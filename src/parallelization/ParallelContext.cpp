@@ -70,6 +70,39 @@ void ParallelContext::pushSequentialContext() {
 #endif
 }
 
+unsigned int ParallelContext::pushGroupContext(unsigned int groups) {
+  assert(groups > 0 && groups <= getSize());
+  auto group = (getRank() * groups) / getSize();
+  if (!_mpiEnabled) {
+    return group;
+  }
+#ifdef WITH_MPI
+  MPI_Comm newComm;
+  MPI_Comm_split(getComm(), static_cast<int>(group),
+                 static_cast<int>(getRank()), &newComm);
+  _commStack.push(newComm);
+  _ownsMPIContextStack.push(_ownsMPIContextStack.top());
+#endif
+  return group;
+}
+
+void ParallelContext::pushParentContext() {
+  if (!_mpiEnabled) {
+    return;
+  }
+#ifdef WITH_MPI
+  assert(_commStack.size() > 1);
+  auto current = _commStack.top();
+  _commStack.pop();
+  // duplicate the parent, such that popContext can free it
+  MPI_Comm newComm;
+  MPI_Comm_dup(_commStack.top(), &newComm);
+  _commStack.push(current);
+  _commStack.push(newComm);
+  _ownsMPIContextStack.push(_ownsMPIContextStack.top());
+#endif
+}
+
 void ParallelContext::popContext() {
   if (!_mpiEnabled) {
     return;
@@ -166,6 +199,19 @@ void ParallelContext::sumULong(unsigned long &value) {
 #endif
 }
 
+void ParallelContext::sumVectorInt64(std::vector<int64_t> &value) {
+#ifdef WITH_MPI
+  if (!_mpiEnabled) {
+    return;
+  }
+  std::vector<int64_t> sum(value.size(), 0);
+  barrier();
+  MPI_Allreduce(&(value[0]), &(sum[0]), static_cast<int>(value.size()),
+                MPI_INT64_T, MPI_SUM, getComm());
+  value = sum;
+#endif
+}
+
 void ParallelContext::sumVectorDouble(std::vector<double> &value) {
 #ifdef WITH_MPI
   if (!_mpiEnabled) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <exception>
 #include <fstream>
 #include <stack>
@@ -83,6 +84,7 @@ public:
   static void sumVectorUInt(std::vector<unsigned int> &value);
   static void maxUInt(unsigned int &value);
   static void sumULong(unsigned long &value);
+  static void sumVectorInt64(std::vector<int64_t> &value);
   static void parallelAnd(bool &value);
 
   /**
@@ -122,6 +124,18 @@ public:
   static MPI_Comm &getComm() { return _commStack.top(); }
 
   static void pushSequentialContext();
+  /**
+   *  Split the ranks of the current context into groups of
+   *  contiguous ranks, and make the group of this rank the current
+   *  context (until popContext)
+   *  @return the index of the group of this rank
+   */
+  static unsigned int pushGroupContext(unsigned int groups);
+  /**
+   *  Make the context below the current one (e.g. all the groups of
+   *  pushGroupContext) the current context, until popContext
+   */
+  static void pushParentContext();
   static void popContext();
 
 private:
@@ -6,99 +6,98 @@
 #include <IO/FileSystem.hpp>
 #include <IO/LibpllParsers.hpp>
 #include <IO/Logger.hpp>
+#include <IO/NewickTreeReader.hpp>
 #include <ccp/ConditionalClades.hpp>
+#include <parallelization/CostModel.hpp>
 #include <parallelization/ParallelContext.hpp>
 #include <trees/PLLRootedTree.hpp>
 #include <util/utils.hpp>
 
 static std::vector<size_t>
-getMyIndices(const std::vector<unsigned int> &treeSizes) {
-  std::vector<size_t> sortedIndices =
-      sort_indices_descending<unsigned int>(treeSizes);
-  std::vector<size_t> myIndices;
-  std::vector<unsigned int> perRankLoad(ParallelContext::getSize(), 0);
-  unsigned int averageLoad = 0;
-  for (auto load : treeSizes) {
-    averageLoad += load;
-  }
-  averageLoad /= ParallelContext::getSize();
-  unsigned int currentRank = 0;
-  for (auto index : sortedIndices) {
-    perRankLoad[currentRank] += treeSizes[index];
-    if (currentRank == ParallelContext::getRank()) {
-      myIndices.push_back(index);
-    }
-    currentRank = (currentRank + 1) % ParallelContext::getSize();
-    for (; perRankLoad[currentRank] > averageLoad;
-         (currentRank = (currentRank + 1) % ParallelContext::getSize())) {
-    }
-  }
-  return myIndices;
-}
-
-static void splitLines(const std::string &input,
-                       std::vector<std::string> &output) {
-  std::stringstream ss(input);
-  std::string to;
-  while (std::getline(ss, to, '\n')) {
-    if (to.size() > 2) {
-      output.push_back(to);
-    }
+getMyIndices(const std::vector<FamilyCostFeatures> &features) {
+  std::vector<double> costs;
+  for (const auto &familyFeatures : features) {
+    costs.push_back(
+        CostModel::predict(CostPhase::Reconciliation, familyFeatures));
   }
+  return CostModel::getMyIndices(costs);
 }
 
-std::vector<unsigned int> getCCPSizes(const Families &families) {
+/**
+ *  In CCP mode, the cost depends on the number of clades
+ *  rather than on the number of tips
+ */
+static std::vector<FamilyCostFeatures>
+getCCPFeatures(const Families &families) {
   unsigned int treesNumber = static_cast<unsigned int>(families.size());
-  std::vector<unsigned int> localTreeSizes(
-      (treesNumber - 1) / ParallelContext::getSize() + 1, 0);
+  // filled by the rank that owns the family and summed
+  std::vector<unsigned int> clades(treesNumber, 0);
+  std::vector<unsigned int> species(treesNumber, 0);
   for (auto i = ParallelContext::getBegin(treesNumber);
        i < ParallelContext::getEnd(treesNumber); i++) {
     ConditionalClades cc;
     cc.unserialize(families[i].ccpFile);
-    localTreeSizes[i - ParallelContext::getBegin(treesNumber)] =
-        cc.getCladesNumber();
+    clades[i] = cc.getCladesNumber();
+    GeneSpeciesMapping mapping;
+    if (families[i].mappingFile.size()) {
+      mapping.fill(families[i].mappingFile, families[i].startingGeneTree);
+    } else {
+      std::unordered_set<std::string> labels;
+      for (const auto &leaf : cc.getCidToLeaves()) {
+        labels.insert(leaf.second);
+      }
+      mapping.fillFromGeneLabels(labels);
+    }
+    species[i] = static_cast<unsigned int>(mapping.getCoveredSpecies().size());
+  }
+  ParallelContext::sumVectorUInt(clades);
+  ParallelContext::sumVectorUInt(species);
+  std::vector<FamilyCostFeatures> features;
+  for (unsigned int i = 0; i < treesNumber; ++i) {
+    features.push_back(FamilyCostFeatures(clades[i], species[i]));
   }
-  std::vector<unsigned int> treeSizes;
-  ParallelContext::concatenateUIntVectors(localTreeSizes, treeSizes);
-  treeSizes.erase(remove(treeSizes.begin(), treeSizes.end(), 0),
-                  treeSizes.end());
-  assert(treeSizes.size() == families.size());
-  return treeSizes;
+  return features;
 }
 
 PerCoreGeneTrees::PerCoreGeneTrees(const Families &families,
                                    bool acceptMultipleTrees, bool ccpMode) {
-  auto treeSizes = ccpMode ? getCCPSizes(families)
-                           : LibpllParsers::parallelGetTreeSizes(families);
-  auto myIndices = getMyIndices(treeSizes);
+  auto features = ccpMode
+                      ? getCCPFeatures(families)
+                      : LibpllParsers::parallelGetCostFeatures(families, false);
+  auto myIndices = getMyIndices(features);
 
   _geneTrees.resize(myIndices.size());
   unsigned int index = 0;
   for (auto i : myIndices) {
-    std::string geneTreeStr;
-    FileSystem::getFileContent(families[i].startingGeneTree, geneTreeStr);
-    std::vector<std::string> geneTreeStrVector;
-    splitLines(geneTreeStr, geneTreeStrVector);
-    if (geneTreeStrVector[0][0] == '#') {
-      geneTreeStr = geneTreeStrVector[1];
-      geneTreeStrVector.clear();
-      geneTreeStrVector.push_back(geneTreeStr);
+    // the trees are parsed in place, without copying the file lines
+    NewickTreeReader reader(families[i].startingGeneTree, true);
+    unsigned int treeNumber = 0;
+    while (reader.next()) {
+      treeNumber++;
     }
+    reader.rewind();
     if (acceptMultipleTrees) {
       if (index == 0) {
-        _geneTrees.resize(myIndices.size() * geneTreeStrVector.size());
+        _geneTrees.resize(myIndices.size() * treeNumber);
       }
     } else {
-      geneTreeStrVector.resize(1);
+      treeNumber = 1;
     }
-    for (auto &currentGeneTreeStr : geneTreeStrVector) {
+    for (unsigned int t = 0; t < treeNumber && reader.next(); ++t) {
+      auto &mappingFile = families[i].mappingFile;
       _geneTrees[index].name = families[i].name;
       _geneTrees[index].familyIndex = i;
-      _geneTrees[index].mapping.fill(families[i].mappingFile,
-                                     currentGeneTreeStr);
       if (!ccpMode) {
         _geneTrees[index].geneTree =
-            new PLLUnrootedTree(currentGeneTreeStr, false);
+            new PLLUnrootedTree(reader.parseUnrooted());
+        _geneTrees[index].geneTree->compact();
+      }
+      if (!ccpMode && mappingFile.empty()) {
+        // no need to parse the tree again to get the labels
+        _geneTrees[index].mapping.fillFromGeneLabels(
+            _geneTrees[index].geneTree->getLabels());
+      } else {
+        _geneTrees[index].mapping.fill(mappingFile, reader.getString());
       }
       _geneTrees[index].startingGeneTreeFile = families[i].startingGeneTree;
       _geneTrees[index].ownTree = true;
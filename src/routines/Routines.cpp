@@ -6,10 +6,13 @@
 #include <IO/FileSystem.hpp>
 #include <IO/LibpllParsers.hpp>
 #include <IO/Logger.hpp>
+#include <likelihoods/EvaluationMemoryManager.hpp>
 #include <likelihoods/LibpllEvaluation.hpp>
+#include <maths/ExactSum.hpp>
 #include <maths/ModelParameters.hpp>
 #include <maths/Random.hpp>
 #include <optimizers/DTLOptimizer.hpp>
+#include <optimizers/MultiStartSpeciesTreeOptimizer.hpp>
 #include <optimizers/SpeciesTreeOptimizer.hpp>
 #include <parallelization/ParallelContext.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
@@ -53,9 +56,9 @@ void Routines::runRaxmlOptimization(Families &families,
                                     const std::string &output,
                                     const std::string &execPath,
                                     unsigned int iteration, bool splitImplem,
-                                    long &sumElapsedSec) {
+                                    long &sumElapsedSec, bool inProcess) {
   RaxmlMaster::runRaxmlOptimization(families, output, execPath, iteration,
-                                    splitImplem, sumElapsedSec);
+                                    splitImplem, sumElapsedSec, inProcess);
 }
 
 void Routines::optimizeGeneTrees(
@@ -65,12 +68,32 @@ void Routines::optimizeGeneTrees(
     RecOpt reconciliationOpt, bool madRooting, double supportThreshold,
     double recWeight, bool enableRec, bool enableLibpll, unsigned int sprRadius,
     unsigned int iteration, bool schedulerSplitImplem, long &elapsed,
-    bool inPlace) {
+    bool inPlace, double timeBudget) {
   GeneRaxMaster::optimizeGeneTrees(
       families, recModelInfo, rates, output, resultName, execPath,
       speciesTreePath, reconciliationOpt, madRooting, supportThreshold,
       recWeight, enableRec, enableLibpll, sprRadius, iteration,
-      schedulerSplitImplem, elapsed, inPlace);
+      schedulerSplitImplem, elapsed, inPlace, timeBudget);
+}
+
+double Routines::optimizeSpeciesTree(
+    const std::string &startingSpeciesTree, const Families &families,
+    const RecModelInfo &recModelInfo, const Parameters &startingRates,
+    bool userDTLRates, const std::string &outputDir,
+    const SpeciesTreeSearchParams &searchParams,
+    SpeciesSearchStrategy strategy) {
+  if (searchParams.multiStartGroups > 1) {
+    std::vector<std::string> startingTrees = {startingSpeciesTree};
+    return MultiStartSpeciesTreeOptimizer::optimize(
+        startingTrees, families, recModelInfo, startingRates, userDTLRates,
+        outputDir, searchParams, strategy);
+  }
+  SpeciesTreeOptimizer optimizer(startingSpeciesTree, families, recModelInfo,
+                                 startingRates, userDTLRates, outputDir,
+                                 searchParams);
+  optimizer.optimize(strategy);
+  optimizer.saveCurrentSpeciesTreeId();
+  return optimizer.computeRecLikelihood();
 }
 
 void Routines::exportPerSpeciesRates(const std::string &speciesTreeFile,
@@ -144,7 +167,11 @@ void Routines::inferAndGetReconciliationScenarios(
     unsigned int reconciliationSamples, bool optimizeRates,
     std::vector<std::shared_ptr<Scenario>> &scenarios) {
   // initialization
-  auto consistentSeed = Random::getInt();
+  // all ranks draw the same value, that keys the sampling streams of
+  // this call: each family is sampled from its own stream, so the
+  // scenarios do not depend on the family distribution among ranks,
+  // and the global random state is not modified by the sampling
+  auto samplingIteration = static_cast<unsigned int>(Random::getInt());
   auto modelParameters = initialModelRates;
   ParallelContext::barrier();
   std::string forcedRootedGeneTree;
@@ -174,6 +201,9 @@ void Routines::inferAndGetReconciliationScenarios(
 
   // infer the scenarios!
   for (unsigned int i = 0; i < geneTrees.getTrees().size(); ++i) {
+    ScopedRandomStream stream(geneTrees.getTrees()[i].familyIndex,
+                              RandomPhase::RECONCILIATION_SAMPLING,
+                              samplingIteration);
     if (reconciliationSamples < 1) {
       scenarios.push_back(std::make_shared<Scenario>());
       evaluations[i]->inferMLScenario(*scenarios[i]);
@@ -181,8 +211,6 @@ void Routines::inferAndGetReconciliationScenarios(
       evaluations[i]->sampleReconciliations(reconciliationSamples, scenarios);
     }
   }
-  // restore the seed to a consistent state
-  Random::setSeed(consistentSeed);
   ParallelContext::barrier();
 }
 
@@ -389,8 +417,8 @@ bool Routines::createRandomTrees(const std::string &geneRaxOutputDir,
 void Routines::gatherLikelihoods(Families &families, double &totalLibpllLL,
                                  double &totalRecLL) {
   ParallelContext::barrier();
-  totalRecLL = 0.0;
-  totalLibpllLL = 0.0;
+  ExactSum recLLSum;
+  ExactSum libpllLLSum;
   unsigned int familiesNumber = static_cast<unsigned int>(families.size());
   for (auto i = ParallelContext::getBegin(familiesNumber);
        i < ParallelContext::getEnd(familiesNumber); ++i) {
@@ -400,11 +428,13 @@ void Routines::gatherLikelihoods(Families &families, double &totalLibpllLL,
     double recLL = 0.0;
     is >> libpllLL;
     is >> recLL;
-    totalRecLL += recLL;
-    totalLibpllLL += libpllLL;
+    recLLSum.add(recLL);
+    libpllLLSum.add(libpllLL);
   }
-  ParallelContext::sumDouble(totalRecLL);
-  ParallelContext::sumDouble(totalLibpllLL);
+  recLLSum.parallelSum();
+  libpllLLSum.parallelSum();
+  totalRecLL = recLLSum.getValue();
+  totalLibpllLL = libpllLLSum.getValue();
 }
 
 static const std::string keyDelimiter("-_-");
@@ -478,9 +508,9 @@ void Routines::getTransfersFrequencies(
   for (auto &scenario : scenarios) {
     potentialTransfers.addScenario(*scenario);
   }
-  const auto labelToId = speciesTree.getDeterministicLabelToId();
-  const auto idToLabel = speciesTree.getDeterministicIdToLabel();
-  const unsigned int labelsNumber = idToLabel.size();
+  const SpeciesRegistry registry(speciesTree);
+  const auto &idToLabel = registry.getIdToLabel();
+  const unsigned int labelsNumber = registry.getSpeciesNumber();
   const VectorUint zeros(labelsNumber, 0);
   transferFrequencies.count = MatrixUint(labelsNumber, zeros);
   transferFrequencies.idToLabel = idToLabel;
@@ -489,14 +519,13 @@ void Routines::getTransfersFrequencies(
     for (unsigned int i = 0; i < geneTrees.getTrees().size(); ++i) {
       auto index = sample * geneTrees.getTrees().size() + i;
       auto &scenario = scenarios[index];
-      scenario->countTransfers(labelToId, transferFrequencies.count);
+      scenario->countTransfers(registry, transferFrequencies.count);
     }
   }
   for (unsigned int i = 0; i < labelsNumber; ++i) {
     ParallelContext::sumVectorUInt(transferFrequencies.count[i]);
   }
   ParallelContext::barrier();
-  assert(ParallelContext::isRandConsistent());
 }
 
 void Routines::buildEvaluations(PerCoreGeneTrees &geneTrees,
@@ -505,6 +534,8 @@ void Routines::buildEvaluations(PerCoreGeneTrees &geneTrees,
                                 Evaluations &evaluations) {
   auto &trees = geneTrees.getTrees();
   evaluations.resize(trees.size());
+  auto memoryManager =
+      EvaluationMemoryManager::create(recModelInfo.memoryBudget);
   for (unsigned int i = 0; i < trees.size(); ++i) {
     auto &tree = trees[i];
     std::string forcedRootedGeneTree;
@@ -514,6 +545,7 @@ void Routines::buildEvaluations(PerCoreGeneTrees &geneTrees,
     evaluations[i] = std::make_shared<ReconciliationEvaluation>(
         speciesTree, *tree.geneTree, tree.mapping, recModelInfo,
         forcedRootedGeneTree);
+    evaluations[i]->setMemoryManager(memoryManager);
   }
 }
 
@@ -10,6 +10,7 @@
 
 class Parameters;
 class ModelParameters;
+struct SpeciesTreeSearchParams;
 class PLLRootedTree;
 class PerCoreGeneTrees;
 class PerCorePotentialTransfers;
@@ -35,13 +36,22 @@ public:
    *                   (or the fork)
    *  @param sumElapsedSec will be incremented by the number of
    *                       seconds spent in this call
+   *  @param inProcess optimize the families on the current ranks
+   *                   instead of scheduling one job per family
+   *                   (always done with a single rank)
    */
   static void runRaxmlOptimization(Families &families,
                                    const std::string &output,
                                    const std::string &execPath,
                                    unsigned int iteration, bool splitImplem,
-                                   long &sumElapsedSec);
+                                   long &sumElapsedSec,
+                                   bool inProcess = false);
 
+  /**
+   *  timeBudget: if positive, wall-clock time (in seconds) allowed for
+   *  the gene tree searches of all families (gene search time budget
+   *  option, parsed with ArgumentsHelper::strToTimeBudget)
+   */
   static void optimizeGeneTrees(
       Families &families, const RecModelInfo &recModelInfo, Parameters &rates,
       const std::string &output, const std::string &resultName,
@@ -49,7 +59,25 @@ public:
       RecOpt reconciliationOpt, bool madRooting, double supportThreshold,
       double recWeight, bool enableRec, bool enableLibpll,
       unsigned int sprRadius, unsigned int iteration, bool schedulerSplitImplem,
-      long &elapsed, bool inPlace = false);
+      long &elapsed, bool inPlace = false, double timeBudget = 0.0);
+  /**
+   *  Species tree search entry point. Runs a multi-start search
+   *  (MultiStartSpeciesTreeOptimizer) if searchParams.multiStartGroups
+   *  is greater than 1 (species multi-start option, parsed with
+   *  ArgumentsHelper::strToMultiStart), and a single
+   *  SpeciesTreeOptimizer search otherwise. In a multi-start search,
+   *  the first group starts from startingSpeciesTree and the other
+   *  groups from random trees. The best tree is saved to
+   *  the inferred_species_tree.newick file of outputDir.
+   *  @return the reconciliation likelihood of the best tree
+   */
+  static double optimizeSpeciesTree(
+      const std::string &startingSpeciesTree, const Families &families,
+      const RecModelInfo &recModelInfo, const Parameters &startingRates,
+      bool userDTLRates, const std::string &outputDir,
+      const SpeciesTreeSearchParams &searchParams,
+      SpeciesSearchStrategy strategy);
+
   /**
    * Optimize the DTL rates for the families families.
    * The result is stored into rates
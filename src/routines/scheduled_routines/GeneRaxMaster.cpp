@@ -5,6 +5,8 @@
 #include <IO/Logger.hpp>
 #include <IO/ParallelOfstream.hpp>
 #include <maths/Parameters.hpp>
+#include <parallelization/CostModel.hpp>
+#include <parallelization/ParallelContext.hpp>
 #include <parallelization/Scheduler.hpp>
 #include <sstream>
 #include <util/RecModelInfo.hpp>
@@ -20,7 +22,7 @@ void GeneRaxMaster::optimizeGeneTrees(
     RecOpt recOpt, bool madRooting, double supportThreshold, double recWeight,
     bool enableRec, bool enableLibpll, unsigned int sprRadius,
     unsigned int iteration, bool schedulerSplitImplem, long &elapsed,
-    bool inPlace) {
+    bool inPlace, double timeBudget) {
   auto start = Logger::getElapsedSec();
   std::stringstream outputDirName;
   outputDirName << "gene_optimization_" << iteration;
@@ -28,12 +30,30 @@ void GeneRaxMaster::optimizeGeneTrees(
   FileSystem::mkdir(outputDir, true);
   std::string commandFile =
       FileSystem::joinPaths(outputDir, "opt_genes_command.txt");
-  auto geneTreeSizes = LibpllParsers::parallelGetTreeSizes(families);
+  auto features =
+      LibpllParsers::parallelGetCostFeatures(families, enableLibpll);
   ParallelOfstream os(commandFile);
   std::string ratesFile = FileSystem::joinPaths(outputDir, "dtl_rates.txt");
   rates.save(ratesFile);
   std::string checkpointDir = FileSystem::joinPaths(outputDir, "checkpoints");
   FileSystem::mkdir(checkpointDir, true);
+  std::vector<double> costs;
+  std::vector<unsigned int> familyCores;
+  double totalCost = 0.0;
+  for (size_t i = 0; i < families.size(); ++i) {
+    costs.push_back(CostModel::predict(CostPhase::GeneTreeSearch, features[i],
+                                       sprRadius));
+    familyCores.push_back(
+        schedulerSplitImplem
+            ? CostModel::getGeneTreeSearchCores(features[i], sprRadius)
+            : 1);
+    totalCost += costs.back() * familyCores.back();
+  }
+  // the global budget (in core-seconds) is shared between the
+  // families in proportion to their predicted cost
+  double coreSeconds = timeBudget * ParallelContext::getSize();
+  auto schedulerCosts = CostModel::toSchedulerCosts(costs);
+  std::vector<std::string> statsFiles;
   for (size_t i = 0; i < families.size(); ++i) {
     auto &family = families[i];
     std::string familyOutput = FileSystem::joinPaths(output, resultName);
@@ -47,24 +67,15 @@ void GeneRaxMaster::optimizeGeneTrees(
       geneTreePath = family.startingGeneTree;
     }
     std::string outputStats = FileSystem::joinPaths(familyOutput, "stats.txt");
-    auto taxa = geneTreeSizes[i];
-    unsigned int cores = 1;
-    if (sprRadius == 1) {
-      cores = taxa / 20;
-    } else if (sprRadius == 2) {
-      cores = taxa / 4;
-    } else if (sprRadius >= 3) {
-      cores = taxa;
-    }
-    if (cores == 0) {
-      cores = 1;
-    }
-    if (!schedulerSplitImplem) {
-      cores = 1;
+    auto cores = familyCores[i];
+    auto cost = costs[i];
+    double familyBudget = 0.0;
+    if (timeBudget > 0.0 && totalCost > 0.0) {
+      familyBudget = coreSeconds * cost / totalCost;
     }
     os << family.name << " ";
-    os << cores << " "; // cores
-    os << taxa << " ";  // cost
+    os << cores << " ";             // cores
+    os << schedulerCosts[i] << " "; // cost
     os << "optimizeGeneTrees" << " ";
     os << family.startingGeneTree << " ";
     os << toArg(family.mappingFile) << " ";
@@ -85,14 +96,18 @@ void GeneRaxMaster::optimizeGeneTrees(
     os << static_cast<int>(enableRec) << " ";
     os << static_cast<int>(enableLibpll) << " ";
     os << sprRadius << " ";
+    os << familyBudget << " ";
     os << geneTreePath << " ";
     os << outputStats << " ";
     os << static_cast<int>(madRooting) << " ";
     os << checkpointPath << std::endl;
     family.startingGeneTree = geneTreePath;
     family.statsFile = outputStats;
+    statsFiles.push_back(outputStats);
   }
   os.close();
   Scheduler::schedule(outputDir, commandFile, schedulerSplitImplem, execPath);
+  CostModel::calibrate(CostPhase::GeneTreeSearch, features, statsFiles,
+                       sprRadius);
   elapsed = (Logger::getElapsedSec() - start);
 }
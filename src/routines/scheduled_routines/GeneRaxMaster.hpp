@@ -19,5 +19,5 @@ public:
       RecOpt reconciliationOpt, bool madRooting, double supportThreshold,
       double recWeight, bool enableRec, bool enableLibpll,
       unsigned int sprRadius, unsigned int iteration, bool schedulerSplitImplem,
-      long &elapsed, bool inPlace = false);
+      long &elapsed, bool inPlace = false, double timeBudget = 0.0);
 };
@@ -5,10 +5,12 @@
 #include <IO/Logger.hpp>
 #include <IO/ParallelOfstream.hpp>
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <maths/Parameters.hpp>
 #include <mpischeduler.hpp>
 #include <optimizers/DTLOptimizer.hpp>
+#include <parallelization/CostModel.hpp>
 #include <parallelization/ParallelContext.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
 #include <routines/scheduled_routines/RaxmlSlave.hpp>
@@ -35,14 +37,94 @@ static void getTreeStrings(const std::string &filename,
   }
 }
 
+/**
+ *  Wall-clock seconds elapsed since start, as measured by the
+ *  master rank, such that all ranks take the same decisions
+ */
+static double getConsistentElapsed(
+    const std::chrono::high_resolution_clock::time_point &start) {
+  std::chrono::duration<double> elapsed =
+      std::chrono::high_resolution_clock::now() - start;
+  double seconds = elapsed.count();
+  ParallelContext::broadcastDouble(0, seconds);
+  return seconds;
+}
+
+// under a time budget, stop when a round gains less than this
+// fraction of the gain per second of the first round
+static const double MIN_RELATIVE_GAIN_RATE = 0.01;
+// under a time budget, try a larger radius if the rounds at the
+// current radius improved the likelihood by at least this much
+static const double MIN_ESCALATION_GAIN = 1.0;
+// maximum number of radius increments under a time budget
+static const int MAX_RADIUS_ESCALATION = 2;
+
+/**
+ *  Apply SPR rounds until no improvement is found. If timeBudget
+ *  (in seconds) is positive, spend the budget where it pays off:
+ *  stop when the next round would not fit in the remaining budget or
+ *  when the marginal gain per second becomes negligible, and give
+ *  larger radii to families that keep improving substantially.
+ */
+static void applySPRRounds(JointTree &jointTree, int sprRadius,
+                           double timeBudget) {
+  if (timeBudget <= 0.0) {
+    while (SPRSearch::applySPRRound(jointTree, sprRadius, true)) {
+      jointTree.saveCheckpoint();
+    }
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  auto radius = sprRadius;
+  double ll = jointTree.computeJointLoglk();
+  double lastRoundSeconds = 0.0;
+  double firstGainRate = -1.0;
+  double radiusGain = 0.0;
+  while (true) {
+    auto roundStart = getConsistentElapsed(start);
+    if (roundStart + lastRoundSeconds > timeBudget) {
+      Logger::info << "Stopping the gene tree search: time budget of "
+                   << timeBudget << "s reached" << std::endl;
+      break;
+    }
+    bool improved = SPRSearch::applySPRRound(jointTree, radius, true);
+    lastRoundSeconds = getConsistentElapsed(start) - roundStart;
+    if (improved) {
+      jointTree.saveCheckpoint();
+      auto newLL = jointTree.computeJointLoglk();
+      auto gain = newLL - ll;
+      ll = newLL;
+      radiusGain += gain;
+      auto gainRate = gain / std::max(lastRoundSeconds, 1e-3);
+      if (firstGainRate < 0.0) {
+        firstGainRate = gainRate;
+      } else if (gainRate < MIN_RELATIVE_GAIN_RATE * firstGainRate) {
+        Logger::info << "Stopping the gene tree search: marginal gain of "
+                     << gain << " in " << lastRoundSeconds << "s"
+                     << std::endl;
+        break;
+      }
+      continue;
+    }
+    if (radius - sprRadius >= MAX_RADIUS_ESCALATION ||
+        radiusGain < MIN_ESCALATION_GAIN) {
+      break;
+    }
+    radius++;
+    radiusGain = 0.0;
+    Logger::info << "Increasing the SPR radius to " << radius << std::endl;
+  }
+}
+
 static void optimizeGeneTreesSlave(
     const std::string &startingGeneTreeFile, const std::string &mappingFile,
     const std::string &alignmentFile, const std::string &speciesTreeFile,
     const std::string &libpllModel, const std::string &ratesFile,
     const RecModelInfo &recModelInfo, RecOpt recOpt, bool madRooting,
     double supportThreshold, double recWeight, bool enableRec,
-    bool enableLibpll, int sprRadius, const std::string &outputGeneTree,
-    const std::string &outputStats, const std::string &checkpointPath) {
+    bool enableLibpll, int sprRadius, double timeBudget,
+    const std::string &outputGeneTree, const std::string &outputStats,
+    const std::string &checkpointPath) {
   auto start = std::chrono::high_resolution_clock::now();
   Logger::timed << "Starting optimizing gene tree" << std::endl;
   Logger::info << "Number of ranks " << ParallelContext::getSize() << std::endl;
@@ -72,9 +154,7 @@ static void optimizeGeneTreesSlave(
   jointTree->printLoglk();
   Logger::info << "Initial ll = " << bestLoglk << std::endl;
   if (sprRadius > 0) {
-    while (SPRSearch::applySPRRound(*jointTree, sprRadius, true)) {
-      jointTree->saveCheckpoint();
-    }
+    applySPRRounds(*jointTree, sprRadius, timeBudget);
   }
   jointTree->printLoglk();
   if (outputGeneTree.size() && ParallelContext::getRank() == 0) {
@@ -82,6 +162,7 @@ static void optimizeGeneTreesSlave(
     jointTree->save(outputGeneTree, false);
     Logger::info << "Finished saving  " << outputGeneTree << std::endl;
   }
+  auto seconds = getConsistentElapsed(start);
   if (outputStats.size()) {
     ParallelOfstream stats(outputStats);
     double libpllLL = jointTree->computeLibpllLoglk();
@@ -91,13 +172,12 @@ static void optimizeGeneTreesSlave(
     for (auto rate : jointTree->getRatesVector().getVector()) {
       stats << rate << " ";
     }
+    stats << std::endl;
+    stats << CostModel::elapsedKey << seconds << std::endl;
     stats.close();
   }
-  auto end = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> elapsed = end - start;
-  auto seconds =
-      std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
-  Logger::timed << "End of optimizing gene tree after " << seconds << "s"
+  Logger::timed << "End of optimizing gene tree after "
+                << static_cast<long>(seconds) << "s"
                 << std::endl;
   ParallelContext::barrier();
 }
@@ -107,7 +187,7 @@ static std::string getArg(const std::string &str) {
 }
 
 int GeneRaxSlave::optimizeGeneTreesMain(int argc, char **argv, void *comm) {
-  assert(argc == 18 + RecModelInfo::getArgc());
+  assert(argc == 19 + RecModelInfo::getArgc());
   ParallelContext::init(comm);
   Logger::timed << "Starting optimizeGeneTreesSlave" << std::endl;
   int i = 2;
@@ -132,6 +212,7 @@ int GeneRaxSlave::optimizeGeneTreesMain(int argc, char **argv, void *comm) {
   bool enableRec = bool(atoi(argv[i++]));
   bool enableLibpll = bool(atoi(argv[i++]));
   int sprRadius = atoi(argv[i++]);
+  double timeBudget = double(atof(argv[i++]));
   std::string outputGeneTree(argv[i++]);
   std::string outputStats(argv[i++]);
   bool madRooting = bool(atoi(argv[i++]));
@@ -139,8 +220,8 @@ int GeneRaxSlave::optimizeGeneTreesMain(int argc, char **argv, void *comm) {
   optimizeGeneTreesSlave(startingGeneTreeFile, mappingFile, alignmentFile,
                          speciesTreeFile, libpllModel, ratesFile, recModelInfo,
                          recOpt, madRooting, supportThreshold, recWeight,
-                         enableRec, enableLibpll, sprRadius, outputGeneTree,
-                         outputStats, checkpointPath);
+                         enableRec, enableLibpll, sprRadius, timeBudget,
+                         outputGeneTree, outputStats, checkpointPath);
   ParallelContext::finalize();
   Logger::timed << "End of optimizeGeneTreesSlave" << std::endl;
   return 0;
@@ -5,14 +5,52 @@
 #include <IO/Logger.hpp>
 #include <IO/ParallelOfstream.hpp>
 #include <functional>
+#include <likelihoods/LibpllEvaluation.hpp>
+#include <parallelization/CostModel.hpp>
+#include <parallelization/ParallelContext.hpp>
 #include <parallelization/Scheduler.hpp>
+#include <routines/scheduled_routines/RaxmlSlave.hpp>
 #include <sstream>
+#include <unordered_map>
+
+struct RaxmlJob {
+  std::string startingGeneTree;
+  std::string alignmentFile;
+  std::string libpllModel;
+  std::string outputGeneTree;
+  std::string outputLibpllModel;
+  std::string outputStats;
+};
+
+static void runJobsInProcess(const std::vector<RaxmlJob> &jobs,
+                             const std::vector<double> &costs) {
+  auto jobToRank = CostModel::assignToRanks(costs);
+  auto rank = ParallelContext::getRank();
+  // families sharing the same model string share the parsed model
+  std::unordered_map<std::string, std::unique_ptr<Model>> models;
+  for (unsigned int i = 0; i < jobs.size(); ++i) {
+    if (jobToRank[i] != rank) {
+      continue;
+    }
+    const auto &job = jobs[i];
+    auto modelStr = LibpllParsers::getModelStr(job.libpllModel);
+    auto &model = models[modelStr];
+    if (!model) {
+      model = std::make_unique<Model>(modelStr);
+    }
+    LibpllEvaluation evaluation(job.startingGeneTree, true, job.alignmentFile,
+                                *model);
+    RaxmlSlave::optimizeAndSave(evaluation, job.outputGeneTree,
+                                job.outputLibpllModel, job.outputStats);
+  }
+  ParallelContext::barrier();
+}
 
 void RaxmlMaster::runRaxmlOptimization(Families &families,
                                        const std::string &output,
                                        const std::string &execPath,
                                        unsigned int iteration, bool splitImplem,
-                                       long &sumElapsedSec)
+                                       long &sumElapsedSec, bool inProcess)
 
 {
   auto start = Logger::getElapsedSec();
@@ -23,8 +61,15 @@ void RaxmlMaster::runRaxmlOptimization(Families &families,
   FileSystem::mkdir(outputDir, true);
   std::string commandFile =
       FileSystem::joinPaths(outputDir, "raxml_light_command.txt");
-  auto geneTreeSizes = LibpllParsers::parallelGetTreeSizes(families);
+  auto features = LibpllParsers::parallelGetCostFeatures(families, true);
   ParallelOfstream os(commandFile);
+  std::vector<double> costs;
+  for (const auto &familyFeatures : features) {
+    costs.push_back(CostModel::predict(CostPhase::Libpll, familyFeatures));
+  }
+  auto schedulerCosts = CostModel::toSchedulerCosts(costs);
+  std::vector<RaxmlJob> jobs;
+  std::vector<std::string> statsFiles;
   for (size_t i = 0; i < families.size(); ++i) {
     auto &family = families[i];
     std::string familyOutput = FileSystem::joinPaths(output, "results");
@@ -35,10 +80,9 @@ void RaxmlMaster::runRaxmlOptimization(Families &families,
         FileSystem::joinPaths(familyOutput, "libpllModel.txt");
     std::string outputStats =
         FileSystem::joinPaths(familyOutput, "raxml_light_stats.txt");
-    auto taxa = geneTreeSizes[i];
     os << family.name << " ";
-    os << 1 << " ";    // cores
-    os << taxa << " "; // cost
+    os << 1 << " ";                 // cores
+    os << schedulerCosts[i] << " "; // cost
     os << "raxmlLight" << " ";
     os << family.startingGeneTree << " ";
     os << family.alignmentFile << " ";
@@ -46,12 +90,21 @@ void RaxmlMaster::runRaxmlOptimization(Families &families,
     os << geneTreePath << " ";
     os << libpllModelPath << " ";
     os << outputStats << std::endl;
+    jobs.push_back({family.startingGeneTree, family.alignmentFile,
+                    family.libpllModel, geneTreePath, libpllModelPath,
+                    outputStats});
     family.startingGeneTree = geneTreePath;
     family.statsFile = outputStats;
+    statsFiles.push_back(outputStats);
     family.libpllModel = libpllModelPath;
   }
   os.close();
-  Scheduler::schedule(outputDir, commandFile, splitImplem, execPath);
+  if (inProcess || ParallelContext::getSize() == 1) {
+    runJobsInProcess(jobs, costs);
+  } else {
+    Scheduler::schedule(outputDir, commandFile, splitImplem, execPath);
+  }
+  CostModel::calibrate(CostPhase::Libpll, features, statsFiles);
   auto elapsed = (Logger::getElapsedSec() - start);
   sumElapsedSec += elapsed;
   Logger::timed << "End of raxml light step (after " << elapsed << "s)"
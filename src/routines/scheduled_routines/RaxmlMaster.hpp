@@ -7,9 +7,18 @@
 class RaxmlMaster {
 public:
   RaxmlMaster() = delete;
+  /**
+   *  Optimize the gene trees of all families from their alignments.
+   *  If inProcess is set, the families are optimized by the current
+   *  ranks instead of jobs scheduled with MPIScheduler, and the
+   *  parsed models are shared between families with the same model.
+   *  This is always the case with a single rank, where scheduling
+   *  one job per family only adds overhead.
+   */
   static void runRaxmlOptimization(Families &families,
                                    const std::string &output,
                                    const std::string &execPath,
                                    unsigned int iteration, bool splitImplem,
-                                   long &sumElapsedSec);
+                                   long &sumElapsedSec,
+                                   bool inProcess = false);
 };
@@ -8,8 +8,10 @@
 #include <IO/Logger.hpp>
 #include <IO/ParallelOfstream.hpp>
 #include <likelihoods/LibpllEvaluation.hpp>
+#include <parallelization/CostModel.hpp>
 #include <parallelization/ParallelContext.hpp>
 #include <string>
+#include <util/Timer.hpp>
 
 static void optimizeParameters(LibpllEvaluation &evaluation, double radius) {
   double initialLL = evaluation.computeLikelihood(false);
@@ -50,6 +52,16 @@ int RaxmlSlave::runRaxmlOptimization(int argc, char **argv, void *comm) {
   Logger::info << startingGeneTreeFile << std::endl;
   LibpllEvaluation evaluation(startingGeneTreeFile, true, alignmentFile,
                               libpllModel);
+  optimizeAndSave(evaluation, outputGeneTree, outputLibpllModel, outputStats);
+  ParallelContext::finalize();
+  return 0;
+}
+
+void RaxmlSlave::optimizeAndSave(LibpllEvaluation &evaluation,
+                                 const std::string &outputGeneTree,
+                                 const std::string &outputLibpllModel,
+                                 const std::string &outputStats) {
+  Timer timer;
   Logger::timed << "LL = " << evaluation.computeLikelihood(false) << std::endl;
   optimizeBranches(evaluation, 1.0);
   optimizeParameters(evaluation, 10.0);
@@ -85,14 +97,15 @@ int RaxmlSlave::runRaxmlOptimization(int argc, char **argv, void *comm) {
       radiusMax = 5;
     }
   }
-  ParallelOfstream stats(outputStats);
-  stats << evaluation.computeLikelihood(false) << " 0.0";
+  bool masterRankOnly = false;
+  ParallelOfstream stats(outputStats, masterRankOnly);
+  stats << evaluation.computeLikelihood(false) << " 0.0" << std::endl;
+  stats << CostModel::elapsedKey
+        << static_cast<double>(timer.getElapsedMs()) / 1000.0 << std::endl;
   stats.close();
   std::string modelStr = evaluation.getModelStr();
-  ParallelOfstream modelWriter(outputLibpllModel);
+  ParallelOfstream modelWriter(outputLibpllModel, masterRankOnly);
   modelWriter << modelStr << std::endl;
   modelWriter.close();
   LibpllParsers::saveUtree(evaluation.getTreeInfo()->root, outputGeneTree);
-  ParallelContext::finalize();
-  return 0;
 }
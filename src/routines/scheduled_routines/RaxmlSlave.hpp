@@ -1,5 +1,9 @@
 #pragma once
 
+#include <string>
+
+class LibpllEvaluation;
+
 class RaxmlSlave {
 public:
   RaxmlSlave() = delete;
@@ -13,4 +17,14 @@ public:
    *
    */
   static int runRaxmlOptimization(int argc, char **argv, void *comm);
+
+  /**
+   *  Run the search on an already built evaluation, and save
+   *  the resulting tree, model and likelihood. The files are
+   *  written by the calling rank, whatever its rank number.
+   */
+  static void optimizeAndSave(LibpllEvaluation &evaluation,
+                              const std::string &outputGeneTree,
+                              const std::string &outputLibpllModel,
+                              const std::string &outputStats);
 };
@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <deque>
+#include <unordered_map>
 
 #include "SpeciesSearchCommon.hpp"
 #include "SpeciesTransferSearch.hpp"
@@ -11,16 +13,126 @@
 #include <parallelization/ParallelContext.hpp>
 #include <trees/SpeciesTree.hpp>
 
+/**
+ *  Bounded cache of the scores of the datings already evaluated
+ *  during one dating search, indexed by the ordering fingerprint.
+ *  Neither the topology nor the model rates change during a dating
+ *  search, so each search uses its own cache and they are not part
+ *  of the key. When full, the oldest entries are evicted first.
+ */
+class DatingCache {
+public:
+  DatingCache(size_t maxSize = 100000) : _maxSize(maxSize) {}
+
+  bool get(const SpeciesTree &speciesTree, double &score) const {
+    auto it = _scores.find(getKey(speciesTree));
+    if (it == _scores.end()) {
+      return false;
+    }
+    score = it->second;
+    return true;
+  }
+
+  void put(const SpeciesTree &speciesTree, double score) {
+    auto key = getKey(speciesTree);
+    if (!_scores.insert({key, score}).second) {
+      return;
+    }
+    _insertionOrder.push_back(key);
+    if (_insertionOrder.size() > _maxSize) {
+      _scores.erase(_insertionOrder.front());
+      _insertionOrder.pop_front();
+    }
+  }
+
+private:
+  using Key = uint64_t;
+  static Key getKey(const SpeciesTree &speciesTree) {
+    return speciesTree.getDatedTree().getOrderingFingerprint();
+  }
+  size_t _maxSize;
+  std::unordered_map<Key, double> _scores;
+  std::deque<Key> _insertionOrder;
+};
+
+// Evaluate the current dating, unless it is already in cache. If
+// searchState is provided and the score gets higher than
+// searchState.bestLL, save the new best tree and update searchState.bestLL
+static double evaluateDating(SpeciesTree &speciesTree,
+                             SpeciesTreeLikelihoodEvaluatorInterface &evaluator,
+                             DatingCache &cache,
+                             SpeciesSearchState *searchState) {
+  double ll;
+  if (cache.get(speciesTree, ll)) {
+    // a cached dating was already compared to searchState->bestLL
+    // when it was evaluated, and bestLL never decreases
+    return ll;
+  }
+  PerFamLL perFamLL;
+  ll = evaluator.computeLikelihood(&perFamLL);
+  cache.put(speciesTree, ll);
+  if (searchState && ll > searchState->bestLL) {
+    // the tree is better than the last saved tree
+    // update searchState to save the tree
+    searchState->betterTreeCallback(ll, perFamLL);
+  }
+  return ll;
+}
+
+// Try to move each speciation far from its current rank (to the
+// bounds of its feasible range, or halfway to them) with a single
+// evaluation per move, to escape the local optima of adjacent swaps.
+// Moves that improve bestLL are kept
+static void
+tryLongRangeMoves(SpeciesTree &speciesTree,
+                  SpeciesTreeLikelihoodEvaluatorInterface &evaluator,
+                  DatingCache &cache, SpeciesSearchState *searchState,
+                  double &bestLL) {
+  auto &datedTree = speciesTree.getDatedTree();
+  auto maxRank = datedTree.getRootedTree().getInnerNodeNumber();
+  for (unsigned int rank = 0; rank < maxRank; ++rank) {
+    unsigned int minFeasible = 0;
+    unsigned int maxFeasible = 0;
+    if (!datedTree.getFeasibleRanks(rank, minFeasible, maxFeasible)) {
+      continue;
+    }
+    std::vector<unsigned int> targets = {minFeasible,
+                                         (minFeasible + rank) / 2,
+                                         (rank + maxFeasible + 1) / 2,
+                                         maxFeasible};
+    for (auto target : targets) {
+      // the adjacent swaps already cover the closest ranks
+      if (target + 1 >= rank && target <= rank + 1) {
+        continue;
+      }
+      datedTree.moveTo(rank, target);
+      speciesTree.onSpeciesDatesChange();
+      auto ll = evaluateDating(speciesTree, evaluator, cache, searchState);
+      if (ll > bestLL) {
+        bestLL = ll;
+        break;
+      }
+      datedTree.moveTo(target, rank);
+    }
+  }
+}
+
 // Search for the speciation order (dating) optimizing the score returned by
 // the evaluator. If searchState is provided and the score gets higher than
 // searchState.bestLL, save the new best tree and update searchState.bestLL
+// Datings already in cache are not evaluated again
 static double
 optimizeDatesLocal(SpeciesTree &speciesTree,
                    SpeciesTreeLikelihoodEvaluatorInterface &evaluator,
+                   DatingCache &cache,
                    SpeciesSearchState *searchState = nullptr) {
   bool verbose = evaluator.isVerbose();
   auto &datedTree = speciesTree.getDatedTree();
-  auto bestLL = evaluator.computeLikelihood();
+  double bestLL;
+  if (!cache.get(speciesTree, bestLL)) {
+    bestLL = evaluator.computeLikelihood();
+    cache.put(speciesTree, bestLL);
+  }
   if (verbose) {
     Logger::timed << "Starting new naive dating search from ll=" << bestLL
                   << std::endl;
@@ -34,13 +146,7 @@ optimizeDatesLocal(SpeciesTree &speciesTree,
         continue;
       }
       speciesTree.onSpeciesDatesChange();
-      PerFamLL perFamLL;
-      auto ll = evaluator.computeLikelihood(&perFamLL);
-      if (searchState && ll > searchState->bestLL) {
-        // the tree is better than the last saved tree
-        // update searchState to save the tree
-        searchState->betterTreeCallback(ll, perFamLL);
-      }
+      auto ll = evaluateDating(speciesTree, evaluator, cache, searchState);
       if (ll > bestLL) {
         // the best tree over all performed iterations
         bestLL = ll;
@@ -49,6 +155,10 @@ optimizeDatesLocal(SpeciesTree &speciesTree,
         datedTree.moveUp(rank); // reversal: the node with rank-1 gets rank
       }
     }
+    // when adjacent swaps stop improving, try larger moves
+    if (bestLL - initialItLL <= 1.0) {
+      tryLongRangeMoves(speciesTree, evaluator, cache, searchState, bestLL);
+    }
     // we'll run another iteration only if the improvement is above 1.0
     tryAgain = (bestLL - initialItLL > 1.0);
     if (verbose) {
@@ -112,8 +222,9 @@ double DatedSpeciesTreeSearch::optimizeDates(
   }
   Logger::timed << "[Species search] Optimizing dates, ll=" << initialLL
                 << std::endl;
+  DatingCache cache;
   // initial optimization
-  auto bestLL = optimizeDatesLocal(speciesTree, evaluator, &searchState);
+  auto bestLL = optimizeDatesLocal(speciesTree, evaluator, cache, &searchState);
   // perturbation-optimization cycles
   const double perturbation = 0.1;
   const unsigned int maxTrials = 2;
@@ -121,7 +232,7 @@ double DatedSpeciesTreeSearch::optimizeDates(
   while (thorough && unsuccessfulTrials < maxTrials) {
     auto backup = speciesTree.getDatedTree().getBackup();
     perturbateDates(speciesTree, perturbation);
-    auto ll = optimizeDatesLocal(speciesTree, evaluator, &searchState);
+    auto ll = optimizeDatesLocal(speciesTree, evaluator, cache, &searchState);
     if (ll > bestLL) {
       bestLL = ll;
       unsuccessfulTrials = 0;
@@ -138,48 +249,111 @@ double DatedSpeciesTreeSearch::optimizeDates(
 
 // Evaluate the current tree dating based on the share of precomputed
 // undated transfer events that are supported by the dating. Better
-// datings permit more precomputed transfers and get higher scores
-static unsigned int getTransferScore(SpeciesTree &speciesTree,
-                                     const TransferFrequencies &frequencies) {
-  unsigned int score = 0;
-  StringToUint labelToId;
-  speciesTree.getLabelToId(labelToId);
-  // parallelize across species for less computational redundancy
-  auto N = frequencies.count.size();
-  auto begin = ParallelContext::getBegin(N);
-  auto end = ParallelContext::getEnd(N);
-  for (unsigned int from = begin; from < end; ++from) {
-    for (unsigned int to = 0; to < N; ++to) {
-      auto count = frequencies.count[from][to];
-      if (count) {
-        // check if the current dating permits the precomputed transfer
-        auto src = labelToId[frequencies.idToLabel[from]];
-        auto dest = labelToId[frequencies.idToLabel[to]];
-        if (speciesTree.getDatedTree().canTransferUnderRelDated(src, dest)) {
-          score += count;
-        }
-      }
-    }
-  }
-  ParallelContext::sumUInt(score);
-  return score;
-}
-
+// datings permit more precomputed transfers and get higher scores.
+// The species tree topology must not change during the evaluator
+// lifetime: only its dating can change.
+//
+// The observed transfers are stored as a sparse list resolved to
+// species node indices. A transfer from e to d is supported if d is
+// younger than the parent p of e, so its status can only change when
+// the rank of p or d changes: each evaluation only updates the
+// transfers involving nodes whose rank changed since the previous one
 class TransferScoreEvaluator : public SpeciesTreeLikelihoodEvaluatorInterface {
 private:
+  struct Transfer {
+    unsigned int parent; // parent of the source species
+    unsigned int dest;
+    unsigned int count;
+    bool supported;
+    unsigned int stamp; // last update in which we visited this transfer
+  };
   SpeciesTree &_speciesTree;
-  TransferFrequencies &_frequencies;
+  std::vector<Transfer> _transfers;
+  // for each species node, the transfers for which it is parent or dest
+  std::vector<std::vector<unsigned int>> _nodeToTransfers;
+  // ranks at the previous evaluation (empty before the first one)
+  std::vector<unsigned int> _ranks;
+  // sum of the counts of supported transfers
+  unsigned int _score;
+  unsigned int _stamp;
+
+  void updateTransfer(Transfer &transfer,
+                      const std::vector<unsigned int> &ranks) {
+    bool supported = ranks[transfer.dest] > ranks[transfer.parent];
+    if (supported != transfer.supported) {
+      if (supported) {
+        _score += transfer.count;
+      } else {
+        _score -= transfer.count;
+      }
+      transfer.supported = supported;
+    }
+  }
 
 public:
   TransferScoreEvaluator(SpeciesTree &speciesTree,
-                         TransferFrequencies &frequencies)
-      : _speciesTree(speciesTree), _frequencies(frequencies) {}
+                         const TransferFrequencies &frequencies)
+      : _speciesTree(speciesTree),
+        _nodeToTransfers(speciesTree.getTree().getNodeNumber()), _score(0),
+        _stamp(0) {
+    // translate the frequency IDs once instead of once per pair
+    const auto &registry = speciesTree.getSpeciesRegistry();
+    auto N = frequencies.count.size();
+    std::vector<unsigned int> idToNode(N);
+    for (unsigned int id = 0; id < N; ++id) {
+      idToNode[id] = registry.getNodeIndexFromLabel(frequencies.idToLabel[id]);
+    }
+    for (unsigned int from = 0; from < N; ++from) {
+      auto src = idToNode[from];
+      auto parent = speciesTree.getTree().getNode(src)->parent;
+      for (unsigned int to = 0; to < N; ++to) {
+        auto count = frequencies.count[from][to];
+        auto dest = idToNode[to];
+        if (!count || src == dest) {
+          continue;
+        }
+        if (!parent) {
+          // transfers from the root are always supported
+          _score += count;
+          continue;
+        }
+        _nodeToTransfers[parent->node_index].push_back(
+            static_cast<unsigned int>(_transfers.size()));
+        _nodeToTransfers[dest].push_back(
+            static_cast<unsigned int>(_transfers.size()));
+        _transfers.push_back({parent->node_index, dest, count, false, 0});
+      }
+    }
+  }
   virtual double computeLikelihood(PerFamLL *perFamLL = nullptr) {
     (void)(perFamLL);
     return computeLikelihoodFast();
   }
   virtual double computeLikelihoodFast() {
-    return getTransferScore(_speciesTree, _frequencies);
+    const auto &ranks =
+        _speciesTree.getDatedTree().getOrderedSpeciesRanks();
+    if (_ranks.empty()) {
+      for (auto &transfer : _transfers) {
+        updateTransfer(transfer, ranks);
+      }
+      _ranks = ranks;
+      return static_cast<double>(_score);
+    }
+    _stamp++;
+    for (unsigned int node = 0; node < ranks.size(); ++node) {
+      if (ranks[node] == _ranks[node]) {
+        continue;
+      }
+      _ranks[node] = ranks[node];
+      for (auto t : _nodeToTransfers[node]) {
+        auto &transfer = _transfers[t];
+        if (transfer.stamp != _stamp) {
+          transfer.stamp = _stamp;
+          updateTransfer(transfer, ranks);
+        }
+      }
+    }
+    return static_cast<double>(_score);
   }
   virtual bool providesFastLikelihoodImpl() const { assert(false); }
   virtual bool isDated() const { assert(false); }
@@ -215,14 +389,26 @@ ScoredBackups DatedSpeciesTreeSearch::getBestDatingsFromReconciliation(
   PerCorePotentialTransfers potentialTransfers;
   evaluator.getTransferInformation(speciesTree, frequencies, perSpeciesEvents,
                                    potentialTransfers);
+  // The restarts are independent and each score evaluation is very
+  // cheap, so each rank runs its own share of the restarts with its
+  // own copy of the transfer list, without any communication. Each
+  // restart has its own random stream, so that the results do not
+  // depend on the number of ranks
+  auto restartsIteration = static_cast<unsigned int>(Random::getInt());
   TransferScoreEvaluator fakeEvaluator(speciesTree, frequencies);
+  DatingCache cache;
   // start multiple searches from random datings
-  for (unsigned int i = 0; i < toTest; ++i) {
+  for (auto i = ParallelContext::getBegin(toTest);
+       i < ParallelContext::getEnd(toTest); ++i) {
+    // the restart draws from its own stream, leaving the global
+    // random state untouched
+    ScopedRandomStream stream(i, RandomPhase::DATING_RESTARTS,
+                              restartsIteration);
     // we should replace this with anything that would produce
     // a random dating more efficiently
     datedTree.randomize();
     // first local search to get to a good starting tree
-    auto bestScore = optimizeDatesLocal(speciesTree, fakeEvaluator);
+    auto bestScore = optimizeDatesLocal(speciesTree, fakeEvaluator, cache);
     // Thorough round: at each step, randomly perturb the tree and
     // perform a local search. If no better tree is found, start
     // again with a greater perturbation, until maxTrials trials
@@ -235,7 +421,7 @@ ScoredBackups DatedSpeciesTreeSearch::getBestDatingsFromReconciliation(
       // the perturbation parameter increases with the number of failures
       double perturbation = double(unsuccessfulTrials + 1) / double(maxTrials);
       perturbateDates(speciesTree, perturbation);
-      auto score = optimizeDatesLocal(speciesTree, fakeEvaluator);
+      auto score = optimizeDatesLocal(speciesTree, fakeEvaluator, cache);
       if (score > bestScore) {
         // better tree found, reset the algorithm
         bestScore = score;
@@ -254,6 +440,26 @@ ScoredBackups DatedSpeciesTreeSearch::getBestDatingsFromReconciliation(
                     << std::endl;
     }
   }
+  // gather the datings of all ranks
+  std::vector<double> localScores;
+  std::vector<unsigned int> localBackups;
+  for (const auto &sb : scoredBackups) {
+    localScores.push_back(sb.score);
+    localBackups.insert(localBackups.end(), sb.backup.begin(),
+                        sb.backup.end());
+  }
+  std::vector<double> scores;
+  std::vector<unsigned int> backups;
+  ParallelContext::concatenateHeterogeneousDoubleVectors(localScores, scores);
+  ParallelContext::concatenateHeterogeneousUIntVectors(localBackups, backups);
+  auto backupSize = reconciliationDatingBackup.size();
+  assert(backups.size() == scores.size() * backupSize);
+  scoredBackups.clear();
+  for (unsigned int i = 0; i < scores.size(); ++i) {
+    auto begin = backups.begin() + i * backupSize;
+    DatedBackup backup(begin, begin + backupSize);
+    scoredBackups.push_back(ScoredBackup(backup, scores[i]));
+  }
   // sort the datings by transfer score and take the best ones
   std::sort(scoredBackups.rbegin(), scoredBackups.rend());
   scoredBackups.resize(toTake);
@@ -0,0 +1,87 @@
+#include "MoveStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// weight (in number of trials) of the move class hit rate when
+// estimating the hit rate of a clade
+static const double CLADE_PRIOR_WEIGHT = 4.0;
+// scale of the exploration bonus of the clades
+static const double EXPLORATION = 0.1;
+// number of trials before adapting the stopping threshold
+static const unsigned int MIN_TRIALS = 20;
+// probability under which a streak of failures is considered unlikely
+static const double STREAK_PROBABILITY = 0.05;
+// weight of a trial in the recent counts after each new trial
+static const double RECENT_DECAY = 0.95;
+
+void MoveStatistics::record(SpeciesMoveType type, unsigned int radius,
+                            unsigned int prune, bool success, double gain) {
+  if (prune >= _perClade.size()) {
+    _perClade.resize(prune + 1);
+  }
+  for (auto counts : {&_perClass[MoveClass(type, radius)], &_perClade[prune]}) {
+    counts->trials++;
+    counts->recentTrials = counts->recentTrials * RECENT_DECAY + 1.0;
+    counts->recentSuccesses *= RECENT_DECAY;
+    if (success) {
+      counts->successes++;
+      counts->recentSuccesses += 1.0;
+      counts->gain += gain;
+    }
+  }
+}
+
+const MoveStatistics::Counts &
+MoveStatistics::getClassCounts(SpeciesMoveType type,
+                               unsigned int radius) const {
+  static const Counts empty;
+  auto it = _perClass.find(MoveClass(type, radius));
+  return it == _perClass.end() ? empty : it->second;
+}
+
+double MoveStatistics::getHitRate(SpeciesMoveType type,
+                                  unsigned int radius) const {
+  const auto &counts = getClassCounts(type, radius);
+  return (counts.successes + 1.0) / (counts.trials + 2.0);
+}
+
+double MoveStatistics::getRecentHitRate(SpeciesMoveType type,
+                                        unsigned int radius) const {
+  const auto &counts = getClassCounts(type, radius);
+  return (counts.recentSuccesses + 1.0) / (counts.recentTrials + 2.0);
+}
+
+double MoveStatistics::getPriority(SpeciesMoveType type, unsigned int radius,
+                                   unsigned int prune) const {
+  const auto &classCounts = getClassCounts(type, radius);
+  auto classRate = getHitRate(type, radius);
+  auto averageGain =
+      classCounts.successes ? classCounts.gain / classCounts.successes : 1.0;
+  Counts cladeCounts;
+  if (prune < _perClade.size()) {
+    cladeCounts = _perClade[prune];
+  }
+  // shrink the clade hit rate towards the move class hit rate
+  auto cladeRate = (cladeCounts.successes + CLADE_PRIOR_WEIGHT * classRate) /
+                   (cladeCounts.trials + CLADE_PRIOR_WEIGHT);
+  auto bonus = EXPLORATION * std::sqrt(std::log(classCounts.trials + 1.0) /
+                                       (cladeCounts.trials + 1.0));
+  return averageGain * (cladeRate + bonus);
+}
+
+unsigned int
+MoveStatistics::getFailureThreshold(SpeciesMoveType type, unsigned int radius,
+                                    unsigned int defaultThreshold) const {
+  if (getClassCounts(type, radius).trials < MIN_TRIALS) {
+    return defaultThreshold;
+  }
+  // the hit rate drops as the search converges: the recent rate
+  // follows it, and a low rate never delays the stop beyond the
+  // default threshold
+  auto rate = getRecentHitRate(type, radius);
+  auto threshold = std::ceil(std::log(STREAK_PROBABILITY) / std::log1p(-rate));
+  threshold = std::min(threshold, static_cast<double>(defaultThreshold));
+  threshold = std::max(threshold, defaultThreshold / 4.0);
+  return std::max(1u, static_cast<unsigned int>(threshold));
+}
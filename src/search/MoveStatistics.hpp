@@ -0,0 +1,73 @@
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+
+enum class SpeciesMoveType { Transfer, SPR };
+
+/**
+ *  Online success statistics of the species tree moves, used to
+ *  test the most promising candidates first and to decide when a
+ *  search round should stop.
+ *
+ *  Statistics are kept per move class (move type and radius, the
+ *  radius being 0 for transfer moves) and per pruned clade. All
+ *  ranks record the same outcomes, so the priorities are consistent
+ *  across ranks without any communication.
+ */
+class MoveStatistics {
+public:
+  /**
+   *  Record the outcome of a tested move. gain is the likelihood
+   *  improvement of the move (ignored if the move failed)
+   */
+  void record(SpeciesMoveType type, unsigned int radius, unsigned int prune,
+              bool success, double gain);
+
+  /**
+   *  Expected likelihood gain per evaluation of a move that prunes
+   *  the clade prune, including an exploration bonus for clades
+   *  that were rarely tested
+   */
+  double getPriority(SpeciesMoveType type, unsigned int radius,
+                     unsigned int prune) const;
+
+  /**
+   *  Number of consecutive failures after which a round of this
+   *  move class can stop: a streak that would be unlikely under the
+   *  recent hit rate. The result never exceeds defaultThreshold,
+   *  which is returned until enough moves have been tested
+   */
+  unsigned int getFailureThreshold(SpeciesMoveType type, unsigned int radius,
+                                   unsigned int defaultThreshold) const;
+
+  /**
+   *  Observed hit rate of a move class (with a uniform prior)
+   */
+  double getHitRate(SpeciesMoveType type, unsigned int radius) const;
+
+  /**
+   *  Hit rate of a move class in which the old trials are
+   *  exponentially down-weighted (with a uniform prior)
+   */
+  double getRecentHitRate(SpeciesMoveType type, unsigned int radius) const;
+
+private:
+  struct Counts {
+    Counts()
+        : trials(0), successes(0), gain(0.0), recentTrials(0.0),
+          recentSuccesses(0.0) {}
+    unsigned int trials;
+    unsigned int successes;
+    double gain;
+    // decayed counts
+    double recentTrials;
+    double recentSuccesses;
+  };
+  using MoveClass = std::pair<SpeciesMoveType, unsigned int>;
+  const Counts &getClassCounts(SpeciesMoveType type, unsigned int radius) const;
+  std::map<MoveClass, Counts> _perClass;
+  // indexed with the pruned node index
+  std::vector<Counts> _perClade;
+};
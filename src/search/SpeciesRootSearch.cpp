@@ -2,7 +2,7 @@
 
 #include "DatedSpeciesTreeSearch.hpp"
 #include <IO/Logger.hpp>
-#include <parallelization/ParallelContext.hpp>
+#include <IO/PerFamilyLikelihoodStream.hpp>
 #include <trees/SpeciesTree.hpp>
 
 static void rootSearchAux(SpeciesTree &speciesTree,
@@ -13,7 +13,7 @@ static void rootSearchAux(SpeciesTree &speciesTree,
                           DatedBackup &bestDatedBackup, double &bestLL,
                           double bestLLStack, unsigned int maxDepth,
                           RootLikelihoods *rootLikelihoods,
-                          TreePerFamLLVec *treePerFamLLVec) {
+                          PerFamilyLikelihoodStream *perFamLLStream) {
   if (movesHistory.size() > maxDepth) {
     return;
   }
@@ -32,12 +32,8 @@ static void rootSearchAux(SpeciesTree &speciesTree,
         speciesTree, evaluator, searchState, !searchState.farFromPlausible);
     PerFamLL perFamLL;
     ll = evaluator.computeLikelihood(&perFamLL);
-    if (treePerFamLLVec) {
-      PerFamLL globalPerFamLL;
-      ParallelContext::concatenateHeterogeneousDoubleVectors(perFamLL,
-                                                             globalPerFamLL);
-      auto newick = speciesTree.toString();
-      treePerFamLLVec->push_back({newick, globalPerFamLL});
+    if (perFamLLStream) {
+      perFamLLStream->addTree(speciesTree.toString(), perFamLL);
     }
     if (rootLikelihoods) {
       auto root = speciesTree.getRoot();
@@ -57,9 +53,12 @@ static void rootSearchAux(SpeciesTree &speciesTree,
     }
     rootSearchAux(speciesTree, evaluator, searchState, movesHistory,
                   bestMovesHistory, bestDatedBackup, bestLL, bestLLStack,
-                  newMaxDepth, rootLikelihoods, treePerFamLLVec);
-    SpeciesTreeOperator::revertChangeRoot(speciesTree, direction);
-    SpeciesTreeOperator::restoreDates(speciesTree, backup);
+                  newMaxDepth, rootLikelihoods, perFamLLStream);
+    {
+      SpeciesTree::ChangeTransaction transaction(speciesTree);
+      SpeciesTreeOperator::revertChangeRoot(speciesTree, direction);
+      SpeciesTreeOperator::restoreDates(speciesTree, backup);
+    }
     evaluator.popAndApplyRollback();
     movesHistory.pop_back();
   }
@@ -69,18 +68,14 @@ double SpeciesRootSearch::rootSearch(
     SpeciesTree &speciesTree,
     SpeciesTreeLikelihoodEvaluatorInterface &evaluator,
     SpeciesSearchState &searchState, unsigned int maxDepth,
-    RootLikelihoods *rootLikelihoods, TreePerFamLLVec *treePerFamLLVec) {
+    RootLikelihoods *rootLikelihoods,
+    PerFamilyLikelihoodStream *perFamLLStream) {
   Logger::timed << "[Species search] Root search with depth=" << maxDepth
                 << std::endl;
   PerFamLL perFamLL;
   double initialLL = evaluator.computeLikelihood(&perFamLL);
-  if (treePerFamLLVec) {
-    treePerFamLLVec->clear();
-    PerFamLL globalPerFamLL;
-    ParallelContext::concatenateHeterogeneousDoubleVectors(perFamLL,
-                                                           globalPerFamLL);
-    auto newick = speciesTree.toString();
-    treePerFamLLVec->push_back({newick, globalPerFamLL});
+  if (perFamLLStream) {
+    perFamLLStream->addTree(speciesTree.toString(), perFamLL);
   }
   if (rootLikelihoods) {
     auto root = speciesTree.getRoot();
@@ -94,15 +89,18 @@ double SpeciesRootSearch::rootSearch(
   movesHistory.push_back(1);
   rootSearchAux(speciesTree, evaluator, searchState, movesHistory,
                 bestMovesHistory, bestDatedBackup, bestLL, initialLL, maxDepth,
-                rootLikelihoods, treePerFamLLVec);
+                rootLikelihoods, perFamLLStream);
   movesHistory[0] = 0;
   rootSearchAux(speciesTree, evaluator, searchState, movesHistory,
                 bestMovesHistory, bestDatedBackup, bestLL, initialLL, maxDepth,
-                rootLikelihoods, treePerFamLLVec);
-  for (unsigned int i = 1; i < bestMovesHistory.size(); ++i) {
-    SpeciesTreeOperator::changeRoot(speciesTree, bestMovesHistory[i]);
+                rootLikelihoods, perFamLLStream);
+  {
+    SpeciesTree::ChangeTransaction transaction(speciesTree);
+    for (unsigned int i = 1; i < bestMovesHistory.size(); ++i) {
+      SpeciesTreeOperator::changeRoot(speciesTree, bestMovesHistory[i]);
+    }
+    SpeciesTreeOperator::restoreDates(speciesTree, bestDatedBackup);
   }
-  SpeciesTreeOperator::restoreDates(speciesTree, bestDatedBackup);
   Logger::timed << "[Species search] After root search: LL=" << bestLL
                 << std::endl;
   return bestLL;
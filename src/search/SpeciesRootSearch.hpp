@@ -2,6 +2,7 @@
 
 #include <search/SpeciesSearchCommon.hpp>
 
+class PerFamilyLikelihoodStream;
 class SpeciesSearchState;
 
 class SpeciesRootSearch {
@@ -10,7 +11,7 @@ public:
    *  Search for the ML root for the current
    *  species tree topology
    *
-   *  rootLikelihoods and treePerFamLLVec
+   *  rootLikelihoods and perFamLLStream
    *  will only be filled if not NULL
    */
   static double rootSearch(SpeciesTree &speciesTree,
@@ -18,5 +19,5 @@ public:
                            SpeciesSearchState &searchState,
                            unsigned int maxDepth,
                            RootLikelihoods *rootLikelihoods = nullptr,
-                           TreePerFamLLVec *treePerFamLLVec = nullptr);
+                           PerFamilyLikelihoodStream *perFamLLStream = nullptr);
 };
@@ -1,6 +1,7 @@
 #include "SpeciesSPRSearch.hpp"
 
 #include "SpeciesSearchCommon.hpp"
+#include <algorithm>
 #include <trees/PLLRootedTree.hpp>
 #include <trees/SpeciesTree.hpp>
 
@@ -16,6 +17,17 @@ bool SpeciesSPRSearch::SPRRound(
   std::vector<unsigned int> prunes;
   SpeciesTreeOperator::getPossiblePrunes(speciesTree, prunes, supportValues,
                                          maxSupport);
+  // try first the prunes that are the most likely to improve the tree
+  auto &statistics = searchState.moveStatistics;
+  std::vector<double> prunePriorities(speciesTree.getTree().getNodeNumber());
+  for (auto prune : prunes) {
+    prunePriorities[prune] =
+        statistics.getPriority(SpeciesMoveType::SPR, radius, prune);
+  }
+  std::stable_sort(prunes.begin(), prunes.end(),
+                   [&](unsigned int p1, unsigned int p2) {
+                     return prunePriorities[p1] > prunePriorities[p2];
+                   });
   bool better = false;
   PerFamLL perFamLL;
   evaluation.computeLikelihood(&perFamLL);
@@ -23,16 +35,18 @@ bool SpeciesSPRSearch::SPRRound(
   for (unsigned int i = 0; i < speciesTree.getTree().getNodeNumber(); ++i) {
     affectedBranches.push_back(i);
   }
-  for (auto &bs : searchState.sprBoots) {
-    bs.test(perFamLL, affectedBranches, true);
-  }
+  searchState.sprBoots.test(perFamLL, affectedBranches, true);
   for (auto prune : prunes) {
     std::vector<unsigned int> regrafts;
     SpeciesTreeOperator::getPossibleRegrafts(speciesTree, prune, radius,
                                              regrafts);
     for (auto regraft : regrafts) {
-      if (SpeciesSearchCommon::testSPR(speciesTree, evaluation, searchState,
-                                       prune, regraft)) {
+      auto previousLL = searchState.bestLL;
+      bool success = SpeciesSearchCommon::testSPR(
+          speciesTree, evaluation, searchState, prune, regraft);
+      statistics.record(SpeciesMoveType::SPR, radius, prune, success,
+                        searchState.bestLL - previousLL);
+      if (success) {
         better = true;
         auto pruneNode = speciesTree.getNode(prune);
         Logger::timed << "\tbetter tree "
@@ -47,12 +61,6 @@ bool SpeciesSPRSearch::SPRRound(
       }
     }
   }
-  for (auto node : speciesTree.getTree().getNodes()) {
-    unsigned int ok = 0;
-    for (auto &bs : searchState.sprBoots) {
-      ok += bs.isOk(node->node_index);
-    }
-  }
   return better;
 }
 
@@ -1,5 +1,6 @@
 #include "SpeciesSearchCommon.hpp"
 
+#include <parallelization/ParallelContext.hpp>
 #include <trees/PLLRootedTree.hpp>
 #include <trees/SpeciesTree.hpp>
 
@@ -50,9 +51,7 @@ void RootLikelihoods::saveRootLikelihood(corax_rnode_t *root, double ll) {
 void RootLikelihoods::savePerFamilyLikelihoods(corax_rnode_t *root,
                                                const PerFamLL &likelihoods) {
   auto id = getRootId(root);
-  for (auto &bs : _bootstraps) {
-    bs.testRoot(likelihoods, id);
-  }
+  _bootstraps.testRoot(likelihoods, id);
 }
 
 void RootLikelihoods::fillTree(PLLRootedTree &tree) {
@@ -88,8 +87,8 @@ void RootLikelihoods::fillTreeBootstraps(PLLRootedTree &tree) {
   for (auto it : _idToLL) {
     idToSupport.insert({it.first, 0});
   }
-  for (const auto &bs : _bootstraps) {
-    idToSupport[bs.getBestID()]++;
+  for (auto bestId : _bootstraps.getBestIDs()) {
+    idToSupport[bestId]++;
   }
   auto postOrderNodes = tree.getPostOrderNodes();
   for (auto it = postOrderNodes.rbegin(); it != postOrderNodes.rend(); ++it) {
@@ -119,8 +118,14 @@ void RootLikelihoods::fillTreeBootstraps(PLLRootedTree &tree) {
 }
 
 void SpeciesSearchState::betterTreeCallback(double ll, PerFamLL &perFamLL) {
-  bool masterRankOnly = true;
-  speciesTree.saveToFile(pathToBestSpeciesTree, masterRankOnly);
+  if (!ParallelContext::getRank()) {
+    if (!_bestTreeWriter) {
+      _bestTreeWriter = std::make_unique<AsyncFileWriter>();
+    }
+    // successive improvements are coalesced by the writer
+    _bestTreeWriter->write(pathToBestSpeciesTree,
+                           speciesTree.toString() + "\n");
+  }
   bestLL = ll;
   khBoots.newMLTree(perFamLL);
   for (auto listener : _listeners) {
@@ -128,6 +133,12 @@ void SpeciesSearchState::betterTreeCallback(double ll, PerFamLL &perFamLL) {
   }
 }
 
+void SpeciesSearchState::flushBestSpeciesTree() {
+  if (_bestTreeWriter) {
+    _bestTreeWriter->flush();
+  }
+}
+
 void SpeciesSearchState::betterLikelihoodCallback(double ll,
                                                   PerFamLL &perFamLL) {
   bestLL = ll;
@@ -161,9 +172,7 @@ bool SpeciesSearchCommon::testSPR(
     // we test the move with exact likelihood
     PerFamLL perFamLL;
     auto testedTreeLL = evaluation.computeLikelihood(&perFamLL);
-    for (auto &bs : searchState.sprBoots) {
-      bs.test(perFamLL, affectedBranches, false);
-    }
+    searchState.sprBoots.test(perFamLL, affectedBranches, false);
     if (evaluation.providesFastLikelihoodImpl()) {
       searchState.averageApproxError.addValue(testedTreeLL - approxLL);
     }
@@ -206,34 +215,28 @@ bool SpeciesSearchCommon::veryLocalSearch(
 }
 
 void SpeciesSearchState::saveSpeciesTreeBP(const std::string &outputFile) {
-  PLLRootedTree tree(speciesTree.getTree().getNewickString(), false);
-  auto m = tree.getNodeIndexMapping(speciesTree.getTree());
-  for (auto node : tree.getNodes()) {
+  // the copy has the same node indices as the species tree
+  auto tree = speciesTree.getTree().clone();
+  for (auto node : tree->getNodes()) {
     if (!node->left) {
       continue;
     }
-    unsigned int ok = 0;
-    for (const auto &bs : sprBoots) {
-      if (bs.isOk(m[node->node_index])) {
-        ok++;
-      }
-    }
+    auto ok = sprBoots.getSupport(node->node_index);
     auto label = std::to_string(ok);
-    tree.setLabel(node->node_index, label);
+    tree->setLabel(node->node_index, label);
   }
-  tree.save(outputFile);
+  tree->save(outputFile);
 }
 
 void SpeciesSearchState::saveSpeciesTreeKH(const std::string &outputFile) {
-  PLLRootedTree tree(speciesTree.getTree().getNewickString(), false);
-  auto m = tree.getNodeIndexMapping(speciesTree.getTree());
-  for (auto node : tree.getNodes()) {
+  auto tree = speciesTree.getTree().clone();
+  for (auto node : tree->getNodes()) {
     if (!node->left) {
       continue;
     }
-    auto ok = khBoots.getSupport(m[node->node_index]);
+    auto ok = khBoots.getSupport(node->node_index);
     auto label = std::to_string(ok);
-    tree.setLabel(node->node_index, label);
+    tree->setLabel(node->node_index, label);
   }
-  tree.save(outputFile);
+  tree->save(outputFile);
 }
@@ -1,17 +1,18 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include <IO/AsyncFileWriter.hpp>
 #include <likelihoods/ReconciliationEvaluation.hpp>
 #include <maths/AverageStream.hpp>
+#include <search/MoveStatistics.hpp>
 #include <search/UFBoot.hpp>
 #include <trees/SpeciesTree.hpp>
 #include <util/Scenario.hpp>
 #include <util/types.hpp>
 
 class PerCorePotentialTransfers;
-using TreePerFamLL = std::pair<std::string, PerFamLL>;
-using TreePerFamLLVec = std::vector<TreePerFamLL>;
 
 /**
  *  Store results (likelihoods, bootstrap info) for each
@@ -19,12 +20,8 @@ using TreePerFamLLVec = std::vector<TreePerFamLL>;
  */
 class RootLikelihoods {
 public:
-  RootLikelihoods(unsigned int localFamilies) {
-    unsigned int samples = 1000;
-    for (unsigned int i = 0; i < samples; ++i) {
-      _bootstraps.push_back(RootBoot(localFamilies));
-    }
-  }
+  RootLikelihoods(unsigned int localFamilies)
+      : _bootstraps(localFamilies, 1000) {}
 
   /*
    *  Reset all results
@@ -32,9 +29,7 @@ public:
   void reset() {
     _idToLL.clear();
     newickToId.clear();
-    for (auto &bs : _bootstraps) {
-      bs.reset();
-    }
+    _bootstraps.reset();
   }
 
   /**
@@ -69,7 +64,7 @@ private:
 
   std::unordered_map<std::string, unsigned int> newickToId;
   std::unordered_map<unsigned int, double> _idToLL;
-  std::vector<RootBoot> _bootstraps;
+  RootBoot _bootstraps;
 };
 
 /**
@@ -166,12 +161,8 @@ public:
                      unsigned int familyNumber)
       : speciesTree(speciesTree), pathToBestSpeciesTree(pathToBestSpeciesTree),
         farFromPlausible(true),
-        khBoots(familyNumber, speciesTree.getTree().getNodeNumber(), 1000) {
-    for (unsigned int i = 0; i < 1000; ++i) {
-      sprBoots.push_back(
-          PerBranchBoot(familyNumber, speciesTree.getTree().getNodeNumber()));
-    }
-  }
+        khBoots(familyNumber, speciesTree.getTree().getNodeNumber(), 1000),
+        sprBoots(familyNumber, speciesTree.getTree().getNodeNumber(), 1000) {}
 
   /**
    *  Reference to the current species tree
@@ -218,8 +209,16 @@ public:
    */
   AverageStream averageApproxError;
 
-  std::vector<PerBranchBoot> sprBoots;
+  // declaration order matters: the replicates of khBoots are
+  // drawn from the random generator before those of sprBoots
   PerBranchKH khBoots;
+  PerBranchBoot sprBoots;
+
+  /**
+   *  Success statistics of the moves tested so far, used to
+   *  prioritize the candidate moves and to stop the rounds
+   */
+  MoveStatistics moveStatistics;
 
   /**
    *  To call when a better tree is found
@@ -235,6 +234,12 @@ public:
   void saveSpeciesTreeKH(const std::string &outputFile);
   void saveSpeciesTreeBP(const std::string &outputFile);
 
+  /**
+   *  Block until the best species tree is written to
+   *  pathToBestSpeciesTree
+   */
+  void flushBestSpeciesTree();
+
   class Listener {
   public:
     /**
@@ -248,6 +253,8 @@ public:
 
 private:
   std::vector<Listener *> _listeners;
+  // writes the best species tree in the background (master rank only)
+  std::unique_ptr<AsyncFileWriter> _bestTreeWriter;
 };
 
 class SpeciesSearchCommon {
@@ -54,12 +54,14 @@ void SpeciesTransferSearch::getSortedTransferList(
   }
   unsigned int transfers = 0;
   ParallelContext::barrier();
-  StringToUint labelToId;
-  speciesTree.getLabelToId(labelToId);
+  // the frequencies were computed on the current tree, so their
+  // IDs are those of the species registry
+  const auto &registry = speciesTree.getSpeciesRegistry();
+  assert(registry.getIdToLabel() == frequencies.idToLabel);
   for (unsigned int from = 0; from < frequencies.count.size(); ++from) {
     for (unsigned int to = 0; to < frequencies.count.size(); ++to) {
-      auto regraft = labelToId[frequencies.idToLabel[from]];
-      auto prune = labelToId[frequencies.idToLabel[to]];
+      auto regraft = registry.getNodeIndex(from);
+      auto prune = registry.getNodeIndex(to);
       auto count = frequencies.count[from][to];
       transfers += count;
       if (count < minTransfers) {
@@ -101,9 +103,7 @@ static bool transferRound(SpeciesTree &speciesTree,
   for (unsigned int i = 0; i < speciesTree.getTree().getNodeNumber(); ++i) {
     affectedBranches.push_back(i);
   }
-  for (auto &bs : searchState.sprBoots) {
-    bs.test(perFamLL, affectedBranches, true);
-  }
+  searchState.sprBoots.test(perFamLL, affectedBranches, true);
   SpeciesTransferSearch::getSortedTransferList(
       speciesTree, evaluation, minTransfers, blacklist, transferMoves);
   auto copyTransferMoves = transferMoves;
@@ -115,8 +115,22 @@ static bool transferRound(SpeciesTree &speciesTree,
     }
   }
   unsigned int speciesNumber = speciesTree.getTree().getNodeNumber();
+  // test first the moves with the highest expected gain, given
+  // their transfer support and what we learnt from previous moves
+  auto &statistics = searchState.moveStatistics;
+  std::vector<double> prunePriorities(speciesNumber);
+  for (unsigned int i = 0; i < speciesNumber; ++i) {
+    prunePriorities[i] =
+        statistics.getPriority(SpeciesMoveType::Transfer, 0, i);
+  }
+  std::stable_sort(transferMoves.begin(), transferMoves.end(),
+                   [&](const TransferMove &m1, const TransferMove &m2) {
+                     return m1.transfers * prunePriorities[m1.prune] >
+                            m2.transfers * prunePriorities[m2.prune];
+                   });
   unsigned int index = 0;
-  const unsigned int stopAfterFailures = 50u;
+  const unsigned int stopAfterFailures =
+      statistics.getFailureThreshold(SpeciesMoveType::Transfer, 0, 50u);
   const unsigned int stopAfterImprovements = std::max(15u, speciesNumber / 4);
   const unsigned int minTrial = std::max(50u, speciesNumber / 2);
   unsigned int failures = 0;
@@ -139,9 +153,13 @@ static bool transferRound(SpeciesTree &speciesTree,
           << speciesTree.getNode(transferMove.regraft)->label
           << std::endl;
           */
-      if (SpeciesSearchCommon::testSPR(speciesTree, evaluation, searchState,
-                                       transferMove.prune,
-                                       transferMove.regraft)) {
+      auto previousLL = searchState.bestLL;
+      bool success = SpeciesSearchCommon::testSPR(
+          speciesTree, evaluation, searchState, transferMove.prune,
+          transferMove.regraft);
+      statistics.record(SpeciesMoveType::Transfer, 0, transferMove.prune,
+                        success, searchState.bestLL - previousLL);
+      if (success) {
         failures = 0;
         improvements++;
         alreadyPruned.insert(transferMove.prune);
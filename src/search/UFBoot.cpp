@@ -1,77 +1,112 @@
 #include "UFBoot.hpp"
 #include <IO/Logger.hpp>
+#include <algorithm>
 #include <cassert>
 #include <limits>
+#include <maths/ExactSum.hpp>
 #include <maths/Random.hpp>
+#include <numeric>
 #include <parallelization/ParallelContext.hpp>
 
-Bootstrap::Bootstrap(unsigned int samples) {
-  assert(ParallelContext::isRandConsistent());
+// number of local elements processed at once by BootstrapMatrix::evaluate,
+// such that the corresponding likelihoods stay in cache while all the
+// replicates are swept
+static const unsigned int EVALUATION_BLOCK_SIZE = 512;
+
+BootstrapMatrix::BootstrapMatrix(unsigned int elements,
+                                 unsigned int replicates)
+    : _elements(elements), _replicates(replicates),
+      _counts(static_cast<size_t>(elements) * replicates, 0) {
   // we generate a subsampling of the elements
-  // samples is the number of samples local to the current core
+  // elements is the number of samples local to the current core
   // we need to subsample over the total number of samples over
   // all cores
-  auto totalSamples = samples;
+  auto totalSamples = elements;
   ParallelContext::sumUInt(totalSamples);
   std::vector<unsigned int> perCoreSamples;
-  ParallelContext::allGatherUInt(samples, perCoreSamples);
+  ParallelContext::allGatherUInt(elements, perCoreSamples);
   unsigned int begin = 0;
   for (unsigned int i = 0; i < ParallelContext::getRank(); ++i) {
     begin += perCoreSamples[i];
   }
-  auto end = begin + samples;
-  for (unsigned int i = 0; i < totalSamples; ++i) {
-    unsigned int v = Random::getInt(0, totalSamples - 1);
-    if (v >= begin && v < end) {
-      indices.push_back(v - begin);
+  auto end = begin + elements;
+  // each matrix gets its own replicates. The iteration is drawn from
+  // the global random state, which is consistent across ranks
+  auto matrix = static_cast<unsigned int>(Random::getInt());
+  for (unsigned int r = 0; r < replicates; ++r) {
+    auto row = &_counts[static_cast<size_t>(r) * elements];
+    // all ranks draw the same subsampling from the replicate stream
+    auto stream = Random::getStream(r, RandomPhase::BOOTSTRAP, matrix);
+    for (unsigned int i = 0; i < totalSamples; ++i) {
+      auto v = static_cast<unsigned int>(stream.getInt(0, totalSamples - 1));
+      if (v >= begin && v < end) {
+        assert(row[v - begin] < std::numeric_limits<uint16_t>::max());
+        row[v - begin]++;
+      }
     }
   }
-  unsigned int totalSize = indices.size();
-  ParallelContext::sumUInt(totalSize);
-  assert(totalSize == totalSamples);
 }
 
-double Bootstrap::evaluate(const std::vector<double> &likelihoods) const {
-  auto ll = 0.0;
-  for (auto i : indices) {
-    ll += likelihoods[i];
+void BootstrapMatrix::evaluate(const std::vector<double> &likelihoods,
+                               std::vector<double> &replicateLLs) const {
+  assert(likelihoods.size() >= _elements);
+  replicateLLs.assign(_replicates, 0.0);
+  for (unsigned int begin = 0; begin < _elements;
+       begin += EVALUATION_BLOCK_SIZE) {
+    auto end = std::min(begin + EVALUATION_BLOCK_SIZE, _elements);
+    for (unsigned int r = 0; r < _replicates; ++r) {
+      auto row = &_counts[static_cast<size_t>(r) * _elements];
+      double ll = 0.0;
+      for (unsigned int e = begin; e < end; ++e) {
+        ll += row[e] * likelihoods[e];
+      }
+      replicateLLs[r] += ll;
+    }
   }
-  ParallelContext::sumDouble(ll);
-  return ll;
+  ParallelContext::sumVectorDouble(replicateLLs);
 }
 
-RootBoot::RootBoot(unsigned int samples) : bootstrap(samples) { reset(); }
+RootBoot::RootBoot(unsigned int elements, unsigned int replicates)
+    : _bootstraps(elements, replicates), _bestIds(replicates),
+      _bestLLs(replicates) {
+  reset();
+}
 
 void RootBoot::testRoot(const std::vector<double> &values, unsigned int id) {
-  double ll = bootstrap.evaluate(values);
-  if (ll > bestLL) {
-    bestId = id;
-    bestLL = ll;
+  _bootstraps.evaluate(values, _replicateLLs);
+  for (unsigned int r = 0; r < _bootstraps.getReplicates(); ++r) {
+    if (_replicateLLs[r] > _bestLLs[r]) {
+      _bestIds[r] = id;
+      _bestLLs[r] = _replicateLLs[r];
+    }
   }
 }
 
 void RootBoot::reset() {
-  bestId = 0;
-  bestLL = std::numeric_limits<double>::lowest();
+  std::fill(_bestIds.begin(), _bestIds.end(), 0);
+  std::fill(_bestLLs.begin(), _bestLLs.end(),
+            std::numeric_limits<double>::lowest());
 }
 
-PerBranchBoot::PerBranchBoot(unsigned int elements, unsigned int branches)
-    : _bootstrap(elements), _bestLLs(branches), _ok(branches) {
+PerBranchBoot::PerBranchBoot(unsigned int elements, unsigned int branches,
+                             unsigned int replicates)
+    : _bootstraps(elements, replicates), _bestLLs(branches * replicates),
+      _ok(branches * replicates) {
   reset();
 }
 
 void PerBranchBoot::test(const std::vector<double> &values,
                          const std::vector<unsigned int> &branches,
                          bool isReferenceTree) {
-  double ll = _bootstrap.evaluate(values);
+  _bootstraps.evaluate(values, _replicateLLs);
+  auto replicates = _bootstraps.getReplicates();
   for (auto branch : branches) {
-
-    if (ll > _bestLLs[branch]) {
-      // Logger::info << "ko " << ll << " " <<  _bestLLs[branch] << std::endl;
-      _bestLLs[branch] = ll;
-      _ok[branch] = isReferenceTree;
-    } else {
-      // Logger::info << "ok " << ll << " " <<  _bestLLs[branch] << std::endl;
+    auto offset = branch * replicates;
+    for (unsigned int r = 0; r < replicates; ++r) {
+      if (_replicateLLs[r] > _bestLLs[offset + r]) {
+        _bestLLs[offset + r] = _replicateLLs[r];
+        _ok[offset + r] = isReferenceTree;
+      }
     }
   }
 }
@@ -82,19 +117,21 @@ void PerBranchBoot::reset() {
   std::fill(_ok.begin(), _ok.end(), true);
 }
 
+unsigned int PerBranchBoot::getSupport(unsigned int branch) const {
+  auto replicates = _bootstraps.getReplicates();
+  auto first = _ok.begin() + branch * replicates;
+  return std::count(first, first + replicates, true);
+}
+
 PerBranchKH::PerBranchKH(unsigned int elements, unsigned int branches,
                          unsigned int bootstraps)
-    : _perBootstrapRefLL(bootstraps, std::numeric_limits<double>::lowest()),
-      _oks(branches, bootstraps) {
-  for (unsigned int i = 0; i < bootstraps; ++i) {
-    _bootstraps.push_back(Bootstrap(elements));
-  }
-}
+    : _bootstraps(elements, bootstraps),
+      _perBootstrapRefLL(bootstraps, std::numeric_limits<double>::lowest()),
+      _oks(branches, bootstraps) {}
 
 void PerBranchKH::test(const std::vector<double> &values,
                        const std::vector<unsigned int> &branches) {
-  double ll2 = std::accumulate(values.begin(), values.end(), 0.0);
-  ParallelContext::sumDouble(ll2);
+  double ll2 = ExactSum::getParallelSum(values);
   if (_refLL - ll2 < -1e-3) {
     Logger::info << "ERROR _refLL - ll2 < -1e-3" << std::endl;
     Logger::info << _refLL << " " << ll2 << std::endl;
@@ -102,17 +139,18 @@ void PerBranchKH::test(const std::vector<double> &values,
   if (_refLL < ll2) {
     ll2 = _refLL;
   }
+  auto bootstraps = _bootstraps.getReplicates();
+  _bootstraps.evaluate(values, _replicateLLs);
   double averageDelta = 0.0;
-  std::vector<double> deltas(_bootstraps.size(), 0.0);
-  for (unsigned int i = 0; i < _bootstraps.size(); ++i) {
-    deltas[i] = _perBootstrapRefLL[i] - _bootstraps[i].evaluate(values);
-    averageDelta += deltas[i];
+  for (unsigned int i = 0; i < bootstraps; ++i) {
+    // the deltas are stored in place of the replicate likelihoods
+    _replicateLLs[i] = _perBootstrapRefLL[i] - _replicateLLs[i];
+    averageDelta += _replicateLLs[i];
   }
-  averageDelta /= static_cast<double>(_bootstraps.size());
-  unsigned int oks = _bootstraps.size();
-  ;
-  for (unsigned int i = 0; i < _bootstraps.size(); ++i) {
-    if (deltas[i] - averageDelta > _refLL - ll2) {
+  averageDelta /= static_cast<double>(bootstraps);
+  unsigned int oks = bootstraps;
+  for (unsigned int i = 0; i < bootstraps; ++i) {
+    if (_replicateLLs[i] - averageDelta > _refLL - ll2) {
       oks--;
     }
   }
@@ -121,14 +159,11 @@ void PerBranchKH::test(const std::vector<double> &values,
   }
 }
 void PerBranchKH::newML(const std::vector<double> &values) {
-  _refLL = std::accumulate(values.begin(), values.end(), 0.0);
-  ParallelContext::sumDouble(_refLL);
-  for (unsigned int i = 0; i < _bootstraps.size(); ++i) {
-    _perBootstrapRefLL[i] = _bootstraps[i].evaluate(values);
-  }
+  _refLL = ExactSum::getParallelSum(values);
+  _bootstraps.evaluate(values, _perBootstrapRefLL);
 }
 
 void PerBranchKH::newMLTree(const std::vector<double> &values) {
   newML(values);
-  std::fill(_oks.begin(), _oks.end(), _bootstraps.size());
+  std::fill(_oks.begin(), _oks.end(), _bootstraps.getReplicates());
 }
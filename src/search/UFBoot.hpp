@@ -1,72 +1,88 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 /**
  *  Helper class for ultra-fast bootstrap
- *  Stores the best bs tree, its likelihood,
- *  and the bootstrap sampling
+ *  Stores the bootstrap sampling of all the replicates as a
+ *  (replicates x local elements) count matrix, such that the
+ *  likelihoods of all the replicates can be computed with a
+ *  single matrix-vector product and a single collective
  */
-class Bootstrap {
+class BootstrapMatrix {
 public:
   /**
    *  Elements is the number of elements in the distribution to sample
    *  for the local parallel core (the boostrapping will be done globally
    *  over all cores)
    */
-  Bootstrap(unsigned int elements);
+  BootstrapMatrix(unsigned int elements, unsigned int replicates);
 
   /**
-   * Evaluate the likelihood for this bootstrap from the per-sample likelihoods
+   *  Evaluate the likelihood of each bootstrap replicate from the
+   *  per-sample likelihoods and store them in replicateLLs
    */
-  double evaluate(const std::vector<double> &likelihoods) const;
+  void evaluate(const std::vector<double> &likelihoods,
+                std::vector<double> &replicateLLs) const;
+
+  unsigned int getReplicates() const { return _replicates; }
 
 private:
-  std::vector<unsigned int> indices;
+  unsigned int _elements;
+  unsigned int _replicates;
+  // _counts[r * _elements + e] is the number of times the local
+  // element e was drawn in the replicate r
+  std::vector<uint16_t> _counts;
 };
 
 class RootBoot {
 public:
   /**
-   *  elements: see the class Bootstrap
+   *  elements: see the class BootstrapMatrix
+   *  replicates: number of bootstrap replicates
    */
-  RootBoot(unsigned int elements);
+  RootBoot(unsigned int elements, unsigned int replicates);
 
   /**
-   *  Evaluate the bootstraped likelihood, and keep id as the best id if its
-   *  value the best bootstraped likelihood encountered so far
+   *  Evaluate the bootstraped likelihoods, and for each replicate keep id
+   *  as the best id if its value the best bootstraped likelihood
+   *  encountered so far
    */
   void testRoot(const std::vector<double> &values, unsigned int id);
 
   /**
-   *  Reset the best likelihood and best ID
+   *  Reset the best likelihoods and best IDs
    */
   void reset();
 
   /**
-   *  Get the best ID encountered so far
+   *  Get the best ID encountered so far for each replicate
    */
-  unsigned int getBestID() const { return bestId; }
+  const std::vector<unsigned int> &getBestIDs() const { return _bestIds; }
 
 private:
-  Bootstrap bootstrap;
-  unsigned int bestId;
-  double bestLL;
+  BootstrapMatrix _bootstraps;
+  std::vector<unsigned int> _bestIds;
+  std::vector<double> _bestLLs;
+  std::vector<double> _replicateLLs;
 };
 
 class PerBranchBoot {
 public:
   /**
-   *  elements: see the class Bootstrap
+   *  elements: see the class BootstrapMatrix
    *  branches: number of branches
+   *  replicates: number of bootstrap replicates
    */
-  PerBranchBoot(unsigned int elements, unsigned int branches);
+  PerBranchBoot(unsigned int elements, unsigned int branches,
+                unsigned int replicates);
 
   /**
-   *  Evaluate the bootstraped likelihood, and for each branch in branches:
-   * update the best likelihood so far and set isOk to isReferenceTree for this
-   * branch if the likelihood was updated
+   *  Evaluate the bootstraped likelihoods, and for each replicate and
+   *  each branch in branches: update the best likelihood so far and set
+   *  isOk to isReferenceTree for this branch if the likelihood was updated
    */
   void test(const std::vector<double> &values,
             const std::vector<unsigned int> &branches, bool isReferenceTree);
@@ -77,15 +93,17 @@ public:
   void reset();
 
   /**
-   *  Return true if this branch is ok (corresponds to the reference tree)
-   *  for this bootstrap
+   *  Return the number of replicates for which this branch is ok
+   *  (corresponds to the reference tree)
    */
-  bool isOk(unsigned int branch) const { return _ok[branch]; }
+  unsigned int getSupport(unsigned int branch) const;
 
 private:
-  Bootstrap _bootstrap;
+  BootstrapMatrix _bootstraps;
+  // indexed with branch * replicates + replicate
   std::vector<double> _bestLLs;
   std::vector<bool> _ok;
+  std::vector<double> _replicateLLs;
 };
 
 class PerBranchKH {
@@ -102,8 +120,9 @@ public:
   unsigned int getSupport(unsigned int branch) const { return _oks[branch]; }
 
 private:
-  std::vector<Bootstrap> _bootstraps;
+  BootstrapMatrix _bootstraps;
   double _refLL;
   std::vector<double> _perBootstrapRefLL;
+  std::vector<double> _replicateLLs;
   std::vector<unsigned int> _oks;
 };
@@ -97,6 +97,16 @@ static unsigned int intersectionSize(const TaxaSet &s1, const TaxaSet &s2) {
   return res;
 }
 
+UInt3 getTripartition(corax_unode_t *u, DSTagger *tagger) {
+  if (tagger) {
+    tagger->orientUp(u);
+  }
+  auto y = u->node_index;
+  auto x1 = u->next->node_index;
+  auto x2 = u->next->next->node_index;
+  return UInt3({x1, x2, y});
+}
+
 void ICCalculator::_computeIntersections() {
   auto speciesNodeCount = _referenceTree.getDirectedNodeNumber();
   auto familyCount = _evaluationTrees.size();
@@ -117,13 +127,18 @@ void ICCalculator::_computeIntersections() {
     fillWithChildren(speciesNode, speciesSets[spid]);
     _speciesSubtreeSizes[spid] = speciesSets[spid].size();
   }
+  _tripartitions.clear();
+  _tripartitions.resize(familyCount);
   for (unsigned int famid = 0; famid < _evaluationTrees.size(); ++famid) {
     auto &geneTree = _evaluationTrees[famid];
-
-    std::unique_ptr<DSTagger> tagger(nullptr);
+    // only the tagger of the current family is kept in memory, so
+    // the tripartitions needed by _computeQuadriCounts are also
+    // computed here, while the family is tagged
+    std::unique_ptr<DSTagger> taggerPtr;
     if (_paralogy) {
-      tagger = std::make_unique<DSTagger>(*geneTree);
+      taggerPtr = std::make_unique<DSTagger>(*geneTree, _taxaNumber);
     }
+    auto tagger = taggerPtr.get();
     for (auto geneNode : geneTree->getPostOrderNodes()) {
       auto geneid = geneNode->node_index;
       if (_paralogy && tagger->isDuplication(geneid)) {
@@ -141,6 +156,9 @@ void ICCalculator::_computeIntersections() {
         _interCounts[famid][geneid][spid] = interSize;
       }
     }
+    for (auto geneNode : geneTree->getInnerNodes()) {
+      _tripartitions[famid].push_back(getTripartition(geneNode, tagger));
+    }
   }
 }
 
@@ -264,16 +282,6 @@ static UInt4 getQuadripartition(corax_unode_t *u, corax_unode_t *v,
   return res;
 }
 
-UInt3 getTripartition(corax_unode_t *u, DSTagger *tagger) {
-  if (tagger) {
-    tagger->orientUp(u);
-  }
-  auto y = u->node_index;
-  auto x1 = u->next->node_index;
-  auto x2 = u->next->next->node_index;
-  return UInt3({x1, x2, y});
-}
-
 static double getLogScore(const std::array<unsigned long, 3> &q) {
   if (q[0] == 0 && q[1] == 0 && q[2] == 0) {
     return 0.0;
@@ -314,17 +322,6 @@ void ICCalculator::_computeQuadriCounts() {
   for (auto node : _referenceTree.getInnerNodes()) {
     speciesInnerNodes.push_back(node);
   }
-  std::vector<std::vector<UInt3>> tripartitions(familyCount);
-  for (unsigned int famid = 0; famid < familyCount; ++famid) {
-    auto &geneTree = _evaluationTrees[famid];
-    std::unique_ptr<DSTagger> tagger(nullptr);
-    if (_paralogy) {
-      tagger = std::make_unique<DSTagger>(*geneTree);
-    }
-    for (auto geneNode : geneTree->getInnerNodes()) {
-      tripartitions[famid].push_back(getTripartition(geneNode, tagger.get()));
-    }
-  }
 
   for (unsigned int i = 0; i < speciesInnerNodes.size(); ++i) {
     auto unode = speciesInnerNodes[i];
@@ -352,7 +349,7 @@ void ICCalculator::_computeQuadriCounts() {
         quadripartitions[topology] = getQuadripartition(unode, vnode, topology);
       }
       for (unsigned int famid = 0; famid < familyCount; ++famid) {
-        for (auto &tripartition : tripartitions[famid]) {
+        for (auto &tripartition : _tripartitions[famid]) {
           for (unsigned int topology = 0; topology < 3; ++topology) {
             if (_paralogy) {
               counts[topology] += _getQuadripartitionCountPro(
@@ -2,6 +2,7 @@
 #include <IO/Families.hpp>
 #include <parallelization/PerCoreGeneTrees.hpp>
 #include <string>
+#include <trees/DSTagger.hpp>
 #include <trees/PLLRootedTree.hpp>
 #include <trees/PLLUnrootedTree.hpp>
 #include <util/types.hpp>
@@ -68,6 +69,8 @@ private:
 
   // evaluation trees data
   std::vector<std::unique_ptr<PLLUnrootedTree>> _evaluationTrees;
+  // tripartitions of the inner nodes of each evaluation tree
+  std::vector<std::vector<UInt3>> _tripartitions;
 
   // debug
   std::vector<std::string> _spidToString;
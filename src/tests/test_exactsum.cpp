@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <maths/ExactSum.hpp>
+#include <random>
+#include <vector>
+
+static bool bitIdentical(double a, double b) {
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static double sumInOrder(const std::vector<double> &values) {
+  ExactSum sum;
+  for (auto value : values) {
+    sum.add(value);
+  }
+  return sum.getValue();
+}
+
+/**
+ *  Values spanning the whole double range, such that a naive
+ *  floating point sum depends on the order of the additions
+ */
+static std::vector<double> getValues() {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+  std::vector<double> values;
+  for (unsigned int i = 0; i < 10000; ++i) {
+    auto exponent = static_cast<int>(rng() % 200) - 100;
+    values.push_back(std::ldexp(mantissa(rng), exponent));
+  }
+  // per-family log-likelihoods
+  for (unsigned int i = 0; i < 1000; ++i) {
+    values.push_back(-1000.0 * std::fabs(mantissa(rng)));
+  }
+  values.push_back(1e300);
+  values.push_back(-1e300);
+  values.push_back(DBL_MAX);
+  values.push_back(-DBL_MAX);
+  values.push_back(4.9e-324);
+  return values;
+}
+
+void testShuffled() {
+  auto values = getValues();
+  auto reference = sumInOrder(values);
+  std::mt19937 rng(1);
+  for (unsigned int i = 0; i < 10; ++i) {
+    std::shuffle(values.begin(), values.end(), rng);
+    assert(bitIdentical(sumInOrder(values), reference));
+  }
+  std::reverse(values.begin(), values.end());
+  assert(bitIdentical(sumInOrder(values), reference));
+}
+
+void testPartialSums() {
+  // partial sums emulate the per-rank sums of different numbers
+  // of ranks and family distributions
+  auto values = getValues();
+  auto reference = sumInOrder(values);
+  std::mt19937 rng(2);
+  for (unsigned int parts = 1; parts <= 64; parts *= 2) {
+    std::shuffle(values.begin(), values.end(), rng);
+    std::vector<ExactSum> partialSums(parts);
+    for (unsigned int i = 0; i < values.size(); ++i) {
+      partialSums[rng() % parts].add(values[i]);
+    }
+    ExactSum total;
+    for (auto it = partialSums.rbegin(); it != partialSums.rend(); ++it) {
+      total.add(*it);
+    }
+    assert(bitIdentical(total.getValue(), reference));
+    // without MPI, parallelSum does not change the local sum
+    total.parallelSum();
+    assert(bitIdentical(total.getValue(), reference));
+  }
+  assert(bitIdentical(ExactSum::getParallelSum(values), reference));
+}
+
+void testExactness() {
+  ExactSum sum;
+  sum.add(1e100);
+  sum.add(1.0);
+  sum.add(-1e100);
+  assert(sum.getValue() == 1.0);
+  ExactSum decimals;
+  decimals.add(0.1);
+  decimals.add(0.2);
+  decimals.add(-0.3);
+  // the exact sum of the three doubles, rounded once
+  assert(decimals.getValue() == std::ldexp(1.0, -55));
+  ExactSum empty;
+  assert(bitIdentical(empty.getValue(), 0.0));
+}
+
+int main(int, char **) {
+  testShuffled();
+  testPartialSums();
+  testExactness();
+  return 0;
+}
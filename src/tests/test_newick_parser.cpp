@@ -0,0 +1,119 @@
+#include <IO/NewickTreeReader.hpp>
+#include <IO/RootedNewickParser.hpp>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <trees/PLLUnrootedTree.hpp>
+
+static corax_utree_t *parse(const std::string &newick, ParsingError &error) {
+  return custom_utree_parse_newick_range(
+      newick.c_str(), newick.c_str() + newick.size(), &error);
+}
+
+static void checkParsed(const std::string &newick,
+                        const std::string &expected) {
+  ParsingError error;
+  auto utree = parse(newick, error);
+  assert(utree);
+  assert(error.type == PET_NOERROR);
+  PLLUnrootedTree tree(utree);
+  PLLUnrootedTree ref(expected, false);
+  assert(tree.getLeafNumber() == ref.getLeafNumber());
+  assert(tree == ref);
+}
+
+static void checkError(const std::string &newick, ParsingErrorType type) {
+  ParsingError error;
+  auto utree = parse(newick, error);
+  assert(!utree);
+  assert(error.type == type);
+}
+
+void testRooted() {
+  // the root is removed
+  checkParsed("((a,b),(c,d));", "(a,b,(c,d));");
+  checkParsed("((a:0.1,b:0.2):0.3,((c,d),e):0.4);", "(a,b,((c,d),e));");
+  checkParsed("(a,(b,(c,d)));", "(a,b,(c,d));");
+}
+
+void testUnrooted() {
+  // the trifurcating top node is kept
+  checkParsed("(a,b,(c,d));", "((a,b),(c,d));");
+  checkParsed("((a,b),c,(d,e))root;", "((a,b),c,(d,e));");
+  checkParsed("(a:1.0,b:2.0,c:3.0);", "(a,b,c);");
+}
+
+void testMultifurcating() {
+  // only the top node can have three children
+  checkError("(a,b,c,d);", PET_UNROOTED);
+  checkError("((a,b,c),d);", PET_POLYTOMY);
+  checkError("((a,b,c),d,e);", PET_POLYTOMY);
+  checkError("(a,(b,c,d),(e,f));", PET_POLYTOMY);
+}
+
+void testRange() {
+  // the parser stops at the end of the range, without a NUL
+  const std::string buffer = "(a,b,(c,d));((a,b),(c,d));";
+  auto middle = buffer.c_str() + buffer.find(';') + 1;
+  ParsingError error;
+  auto utree1 = custom_utree_parse_newick_range(buffer.c_str(), middle, &error);
+  assert(utree1 && error.type == PET_NOERROR);
+  auto end = buffer.c_str() + buffer.size();
+  auto utree2 = custom_utree_parse_newick_range(middle, end, &error);
+  assert(utree2 && error.type == PET_NOERROR);
+  PLLUnrootedTree tree1(utree1);
+  PLLUnrootedTree tree2(utree2);
+  assert(tree1 == tree2);
+  checkError("(a,b,(c,d));(e,f);", PET_TOKEN_AFTER_SEMICOLON);
+}
+
+void testComments() {
+  // comments are ignored wherever a token can start
+  checkParsed("[c](a[&&NHX:S=x],b:[c]1.0,(c,d)[;]);", "(a,b,(c,d));");
+  checkParsed("((a,b)[&support=1]:0.5,(c,d));[end]", "(a,b,(c,d));");
+  checkError("(a,b,(c,d))[unterminated;", PET_INVALID_LABEL);
+}
+
+void testQuotedLabels() {
+  ParsingError error;
+  auto utree = parse("('a b',\"c,d\",('it''s',e:1.0));", error);
+  assert(utree && error.type == PET_NOERROR);
+  PLLUnrootedTree tree(utree);
+  auto labels = tree.getLeafLabels();
+  assert(labels.size() == 4);
+  assert(labels.count("a b") && labels.count("c,d"));
+  assert(labels.count("it's") && labels.count("e"));
+  checkError("('a,b,(c,d));", PET_INVALID_LABEL);
+}
+
+void testReader() {
+  // semicolons and newlines in comments or quoted labels do not end
+  // the tree
+  const std::string filename = "test_newick_parser_reader.txt";
+  {
+    std::ofstream os(filename);
+    os << "(a,b,(c,d))[x;\ny];" << std::endl;
+    os << "('e;f',b,(c,d));" << std::endl;
+  }
+  NewickTreeReader reader(filename);
+  unsigned int trees = 0;
+  while (reader.next()) {
+    PLLUnrootedTree tree(reader.parseUnrooted());
+    assert(tree.getLeafNumber() == 4);
+    ++trees;
+  }
+  assert(trees == 2);
+  std::remove(filename.c_str());
+}
+
+int main(int, char **) {
+  testRooted();
+  testUnrooted();
+  testMultifurcating();
+  testRange();
+  testComments();
+  testQuotedLabels();
+  testReader();
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <IO/Logger.hpp>
+#include <cassert>
+#include <parallelization/ParallelContext.hpp>
+#include <vector>
+
+/**
+ *  Run with any number of MPI ranks (e.g. mpiexec -np 5)
+ */
+
+void testGroupContext(unsigned int groups) {
+  auto globalRank = ParallelContext::getRank();
+  auto globalSize = ParallelContext::getSize();
+  auto group = ParallelContext::pushGroupContext(groups);
+  assert(group < groups);
+  assert(group == (globalRank * groups) / globalSize);
+  // the groups are made of contiguous ranks, in the same order
+  std::vector<unsigned int> groupGlobalRanks;
+  ParallelContext::allGatherUInt(globalRank, groupGlobalRanks);
+  assert(groupGlobalRanks.size() == ParallelContext::getSize());
+  assert(groupGlobalRanks[ParallelContext::getRank()] == globalRank);
+  for (unsigned int i = 1; i < groupGlobalRanks.size(); ++i) {
+    assert(groupGlobalRanks[i] == groupGlobalRanks[i - 1] + 1);
+  }
+  // collectives only involve the ranks of the group
+  unsigned int groupSize = 1;
+  ParallelContext::sumUInt(groupSize);
+  assert(groupSize == ParallelContext::getSize());
+  unsigned int groupMax = globalRank;
+  ParallelContext::maxUInt(groupMax);
+  assert(groupMax == groupGlobalRanks.back());
+
+  // the parent context gives back all the ranks
+  ParallelContext::pushParentContext();
+  assert(ParallelContext::getRank() == globalRank);
+  assert(ParallelContext::getSize() == globalSize);
+  std::vector<unsigned int> allGroups;
+  ParallelContext::allGatherUInt(group, allGroups);
+  assert(allGroups.size() == globalSize);
+  unsigned int sameGroup = 0;
+  for (unsigned int rank = 0; rank < globalSize; ++rank) {
+    assert(allGroups[rank] == (rank * groups) / globalSize);
+    sameGroup += (allGroups[rank] == group);
+  }
+  assert(sameGroup == groupSize);
+  ParallelContext::popContext();
+
+  // back to the group
+  unsigned int size = 1;
+  ParallelContext::sumUInt(size);
+  assert(size == groupSize);
+  ParallelContext::popContext();
+  assert(ParallelContext::getRank() == globalRank);
+  assert(ParallelContext::getSize() == globalSize);
+}
+
+int main(int, char **) {
+  Logger::init();
+#ifdef WITH_MPI
+  ParallelContext::init(nullptr);
+#else
+  int noMPI = -1;
+  ParallelContext::init(&noMPI);
+#endif
+  for (unsigned int groups = 1; groups <= ParallelContext::getSize();
+       ++groups) {
+    testGroupContext(groups);
+  }
+  ParallelContext::finalize();
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <maths/Random.hpp>
+#include <maths/RandomStream.hpp>
+#include <set>
+#include <vector>
+
+static std::vector<uint32_t> draw(RandomStream stream, unsigned int n) {
+  std::vector<uint32_t> res;
+  for (unsigned int i = 0; i < n; ++i) {
+    res.push_back(stream.getUInt32());
+  }
+  return res;
+}
+
+void testKnownAnswers() {
+  // Random123 known-answer test for Philox4x32-10 (key and counter
+  // set to 0), followed by the next block of the stream
+  std::vector<uint32_t> zero = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                0x9b00dbd8, 0x2dce73e5, 0x1348e23f,
+                                0xfcf8e0ec, 0xa287aadb};
+  assert(draw(RandomStream(0, 0, RandomPhase::BOOTSTRAP, 0), 8) == zero);
+  // key and counter words of the Random123 "pi" test, checked with
+  // an independent implementation that passes the reference tests
+  std::vector<uint32_t> pi = {0x430caa29, 0x233a499b, 0x2fe5dd94,
+                              0x732d96eb, 0x40a92962, 0x73eef146,
+                              0x0c48dfa2, 0xc269401d};
+  RandomStream piStream(0x299f31d0a4093822ULL, 0x243f6a88,
+                        RandomPhase::RECONCILIATION_SAMPLING, 0x13198a2e);
+  assert(draw(piStream, 8) == pi);
+}
+
+void testStreamIndependence() {
+  // the same context always gives the same numbers
+  RandomStream ref(42, 7, RandomPhase::DATING_RESTARTS, 3);
+  assert(draw(ref, 100) == draw(ref, 100));
+  // changing any part of the context changes the stream
+  std::set<std::vector<uint32_t>> starts;
+  for (uint32_t family = 0; family < 1000; ++family) {
+    for (auto phase : {RandomPhase::BOOTSTRAP, RandomPhase::DATING_RESTARTS,
+                       RandomPhase::RECONCILIATION_SAMPLING}) {
+      for (uint32_t iteration = 0; iteration < 4; ++iteration) {
+        starts.insert(draw(RandomStream(42, family, phase, iteration), 2));
+      }
+    }
+  }
+  assert(starts.size() == 1000 * 3 * 4);
+  assert(draw(RandomStream(43, 7, RandomPhase::DATING_RESTARTS, 3), 100) !=
+         draw(ref, 100));
+  // interleaved draws from two streams do not interfere
+  RandomStream a(42, 1, RandomPhase::BOOTSTRAP);
+  RandomStream b(42, 2, RandomPhase::BOOTSTRAP);
+  std::vector<uint32_t> interleavedA;
+  std::vector<uint32_t> interleavedB;
+  for (unsigned int i = 0; i < 100; ++i) {
+    interleavedA.push_back(a.getUInt32());
+    interleavedB.push_back(b.getUInt32());
+    b.getUInt32();
+  }
+  auto separateA = draw(RandomStream(42, 1, RandomPhase::BOOTSTRAP), 100);
+  auto separateB = draw(RandomStream(42, 2, RandomPhase::BOOTSTRAP), 200);
+  assert(interleavedA == separateA);
+  for (unsigned int i = 0; i < 100; ++i) {
+    assert(interleavedB[i] == separateB[2 * i]);
+  }
+}
+
+void testScopedStream() {
+  Random::setSeed(12);
+  auto expected = Random::getInt();
+  Random::setSeed(12);
+  auto stream = Random::getStream(5, RandomPhase::RECONCILIATION_SAMPLING);
+  {
+    // draws come from the stream, and the global state is untouched
+    ScopedRandomStream scoped(5, RandomPhase::RECONCILIATION_SAMPLING);
+    for (unsigned int i = 0; i < 10; ++i) {
+      assert(Random::getInt() == stream.getInt());
+    }
+  }
+  assert(Random::getInt() == expected);
+}
+
+void testDistributions() {
+  RandomStream stream(1, 0, RandomPhase::BOOTSTRAP);
+  const unsigned int n = 100000;
+  double sum = 0.0;
+  std::vector<unsigned int> histogram(6, 0);
+  for (unsigned int i = 0; i < n; ++i) {
+    auto proba = stream.getProba();
+    assert(proba >= 0.0 && proba < 1.0);
+    sum += proba;
+    auto value = stream.getInt(3, 8);
+    assert(value >= 3 && value <= 8);
+    histogram[value - 3]++;
+  }
+  assert(std::fabs(sum / n - 0.5) < 0.01);
+  for (auto count : histogram) {
+    assert(std::fabs(count / double(n) - 1.0 / 6.0) < 0.01);
+  }
+}
+
+int main(int, char **) {
+  testKnownAnswers();
+  testStreamIndependence();
+  testScopedStream();
+  testDistributions();
+  return 0;
+}
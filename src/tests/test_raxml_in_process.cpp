@@ -0,0 +1,95 @@
+#include <IO/FileSystem.hpp>
+#include <IO/Logger.hpp>
+#include <cassert>
+#include <fstream>
+#include <parallelization/CostModel.hpp>
+#include <parallelization/ParallelContext.hpp>
+#include <routines/scheduled_routines/RaxmlMaster.hpp>
+#include <string>
+#include <trees/PLLUnrootedTree.hpp>
+
+/**
+ *  Run with any number of MPI ranks (e.g. mpiexec -np 3)
+ */
+
+static const std::string outputDir = "test_raxml_in_process";
+
+static void writeFamily(FamilyInfo &family, unsigned int index) {
+  family.name = "family" + std::to_string(index);
+  family.alignmentFile =
+      FileSystem::joinPaths(outputDir, family.name + ".fasta");
+  family.startingGeneTree =
+      FileSystem::joinPaths(outputDir, family.name + ".newick");
+  family.libpllModel = "GTR";
+  if (ParallelContext::getRank() == 0) {
+    std::ofstream ali(family.alignmentFile);
+    ali << ">A\nACGTACGTAACCGGTTACGTACGTAGCT\n";
+    ali << ">B\nACGTACGTAACCGGTTACGTACGAAGCT\n";
+    ali << ">C\nACGAACGTAACCGGTAACGTACGTAGCA\n";
+    ali << ">D\nTCGAACGTTACCGCTAACGTTCGTAGCA\n";
+    ali << ">E\nTCGAACCTTACCGCTAAGGTTCGAAGCA\n";
+    ali << ">F\nTCGAACCTTACCGCTAAGGTTCGAAGGA\n";
+    std::ofstream tree(family.startingGeneTree);
+    tree << "((A:0.1,D:0.1):0.1,C:0.1,(B:0.1,(E:0.1,F:0.1):0.1):0.1);"
+         << std::endl;
+  }
+  FileSystem::mkdir(FileSystem::joinPaths(
+                        FileSystem::joinPaths(outputDir, "results"),
+                        family.name),
+                    true);
+}
+
+static bool hasElapsedLine(const std::string &statsFile) {
+  std::ifstream is(statsFile);
+  std::string key(CostModel::elapsedKey);
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.compare(0, key.size(), key) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void testInProcess(unsigned int familiesNumber) {
+  FileSystem::mkdir(outputDir, true);
+  FileSystem::mkdir(FileSystem::joinPaths(outputDir, "results"), true);
+  Families families(familiesNumber);
+  for (unsigned int i = 0; i < familiesNumber; ++i) {
+    writeFamily(families[i], i);
+  }
+  ParallelContext::barrier();
+  long elapsed = 0;
+  RaxmlMaster::runRaxmlOptimization(families, outputDir, "", 0, false,
+                                    elapsed, true);
+  for (const auto &family : families) {
+    // the families now point to the outputs of the search
+    PLLUnrootedTree tree(family.startingGeneTree);
+    assert(tree.getLeafNumber() == 6);
+    std::ifstream stats(family.statsFile);
+    double ll = 0.0;
+    stats >> ll;
+    assert(ll < 0.0);
+    // the duration is reported for the calibration of the cost model
+    assert(hasElapsedLine(family.statsFile));
+    std::ifstream model(family.libpllModel);
+    std::string modelStr;
+    std::getline(model, modelStr);
+    assert(modelStr.size());
+  }
+}
+
+int main(int, char **) {
+  Logger::init();
+#ifdef WITH_MPI
+  ParallelContext::init(nullptr);
+#else
+  int noMPI = -1;
+  ParallelContext::init(&noMPI);
+#endif
+  // fewer and more families than ranks
+  testInProcess(1);
+  testInProcess(ParallelContext::getSize() + 2);
+  ParallelContext::finalize();
+  return 0;
+}
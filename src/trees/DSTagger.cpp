@@ -1,13 +1,39 @@
 #include "DSTagger.hpp"
 #include <IO/Logger.hpp>
+#include <algorithm>
+#include <cassert>
 #include <climits>
 #include <sstream>
 
-DSTagger::DSTagger(PLLUnrootedTree &tree)
-    : _tree(tree), _isRootDup(false), _clvs(_tree.getDirectedNodeNumber() + 3) {
+static unsigned int getSpeciesNumber(const PLLUnrootedTree &tree) {
+  unsigned int res = 0;
+  for (auto leaf : tree.getLeaves()) {
+    res = std::max(res, leaf->clv_index + 1);
+  }
+  return res;
+}
+
+DSTagger::DSTagger(PLLUnrootedTree &tree, unsigned int speciesNumber)
+    : _tree(tree), _isRootDup(false), _clvs(_tree.getDirectedNodeNumber() + 3),
+      _cladeWords(0) {
+  if (!speciesNumber) {
+    speciesNumber = getSpeciesNumber(_tree);
+  }
+  // number the species of this tree
+  _speciesToLocal.assign(speciesNumber, UINT_MAX);
+  for (auto leaf : _tree.getLeaves()) {
+    auto &local = _speciesToLocal[leaf->clv_index];
+    if (local == UINT_MAX) {
+      local = static_cast<unsigned int>(_localToSpecies.size());
+      _localToSpecies.push_back(leaf->clv_index);
+    }
+  }
+  auto localSpecies = static_cast<unsigned int>(_localToSpecies.size());
+  _cladeWords = (localSpecies + WordSize - 1) / WordSize;
+  _clades.resize(_tree.getDirectedNodeNumber() * _cladeWords, 0);
   for (auto node : _tree.getPostOrderNodes()) {
     auto &clv = _clvs[node->node_index];
-    _tagNode(node, clv);
+    _tagNode(node, clv, _getClade(node->node_index));
   }
 
   // here we create a fake node with fake children
@@ -22,7 +48,8 @@ DSTagger::DSTagger(PLLUnrootedTree &tree)
     fakeNext.back = branch;
     fakeNextNext.back = branch->back;
     CLV clv;
-    _tagNode(&fakeNode, clv);
+    // the clade of the virtual root is not needed
+    _tagNode(&fakeNode, clv, nullptr);
     if (clv.score == bestScore) {
       _bestRoots.push_back(branch);
     } else if (clv.score < bestScore) {
@@ -34,6 +61,7 @@ DSTagger::DSTagger(PLLUnrootedTree &tree)
       }
     }
   }
+  std::vector<unsigned int>().swap(_speciesToLocal);
   auto rootBranch = getRoot();
   _clvs[rootBranch->node_index].isRoot = true;
   _clvs[rootBranch->back->node_index].isRoot = true;
@@ -61,23 +89,39 @@ void DSTagger::fillUpTraversal(corax_unode_t *node, TaxaSet &set) {
   }
 }
 
-void DSTagger::_tagNode(corax_unode_t *node, CLV &clv) {
+void DSTagger::_tagNode(corax_unode_t *node, CLV &clv, Word *clade) {
   if (!node->next) {
     // leaf case, nothing to do
-    clv.clade.insert(node->clv_index);
+    auto local = _speciesToLocal[node->clv_index];
+    clade[local / WordSize] |= Word(1) << (local % WordSize);
     return;
   }
-  auto &leftCLV = _clvs[node->next->back->node_index];
-  auto &rightCLV = _clvs[node->next->next->back->node_index];
-  auto &leftClade = leftCLV.clade;
-  auto &rightClade = rightCLV.clade;
+  auto leftIndex = node->next->back->node_index;
+  auto rightIndex = node->next->next->back->node_index;
+  auto &leftCLV = _clvs[leftIndex];
+  auto &rightCLV = _clvs[rightIndex];
+  const auto *leftClade = _getClade(leftIndex);
+  const auto *rightClade = _getClade(rightIndex);
   clv.score = leftCLV.score + rightCLV.score;
-  clv.clade.insert(leftClade.begin(), leftClade.end());
-  clv.clade.insert(rightClade.begin(), rightClade.end());
-  clv.isDup = clv.clade.size() != (leftClade.size() + rightClade.size());
+  // the union of both clades equals the left (resp. right) clade
+  // iff the right (resp. left) clade is included in the left one
+  bool intersect = false;
+  bool rightInLeft = true;
+  bool leftInRight = true;
+  for (unsigned int i = 0; i < _cladeWords; ++i) {
+    auto l = leftClade[i];
+    auto r = rightClade[i];
+    intersect |= (l & r) != 0;
+    rightInLeft &= (r & ~l) == 0;
+    leftInRight &= (l & ~r) == 0;
+    if (clade) {
+      clade[i] = l | r;
+    }
+  }
+  clv.isDup = intersect;
   if (clv.isDup) {
-    if (clv.clade == leftClade || clv.clade == rightClade) {
-      if (leftClade == rightClade) {
+    if (rightInLeft || leftInRight) {
+      if (rightInLeft && leftInRight) {
         clv.score += 1;
       } else {
         clv.score += 2;
@@ -123,18 +167,17 @@ void DSTagger::TaggerUNodePrinter::operator()(corax_unode_t *node,
   ss << ":" << node->length;
 }
 
-static void _fillWithChildren(corax_unode_t *node, TaxaSet &set) {
-  if (!node->next) {
-    set.insert(node->clv_index);
-  } else {
-    _fillWithChildren(node->next->back, set);
-    _fillWithChildren(node->next->next->back, set);
-  }
-}
-
 void DSTagger::fillWithChildren(corax_unode_t *node, TaxaSet &set) {
   orientUp(node);
-  _fillWithChildren(node, set);
+  const auto *clade = _getClade(node->node_index);
+  for (unsigned int i = 0; i < _cladeWords; ++i) {
+    auto word = clade[i];
+    while (word) {
+      auto bit = static_cast<unsigned int>(__builtin_ctzll(word));
+      set.insert(_localToSpecies[i * WordSize + bit]);
+      word &= word - 1;
+    }
+  }
 }
 
 std::vector<corax_unode_t *>
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <set>
+#include <cstdint>
+#include <memory>
 #include <trees/PLLUnrootedTree.hpp>
 #include <util/types.hpp>
 #include <vector>
@@ -10,10 +11,23 @@ class Clade;
  *  Apply astral-pro tagging
  *  Assumes that the species ID is stored in
  *  the clv_index field of the corax_unode_t structure
+ *
+ *  The clade (set of species) under each directed node
+ *  is stored as a packed bitset, and all the bitsets of a
+ *  tree live in a single contiguous buffer. The bits are
+ *  indexed by the species present in the tree (not by the
+ *  global species IDs), so the bitsets are as small as the
+ *  tree itself allows
  */
 class DSTagger {
 public:
-  DSTagger(PLLUnrootedTree &tree);
+  /**
+   *  @param tree the tree to tag
+   *  @param speciesNumber an upper bound on the species IDs
+   *  stored in the leaves. If 0, it is computed from the tree
+   */
+  DSTagger(PLLUnrootedTree &tree, unsigned int speciesNumber = 0);
+
   corax_unode_t *&getRoot() { return _bestRoots[_bestRoots.size() / 2]; }
   bool isDuplication(unsigned int nodeIndex) const {
     return _clvs[nodeIndex].isDup;
@@ -67,23 +81,35 @@ public:
   }
 
 private:
+  using Word = uint64_t;
+  static const unsigned int WordSize = sizeof(Word) * 8;
   PLLUnrootedTree &_tree;
   bool _isRootDup;
 
   std::array<corax_unode_t, 3> _roots;
-  using Clade = std::set<unsigned int>;
   struct CLV {
     unsigned int score;
     bool isDup;
     bool isRoot;
-    Clade clade;
     corax_unode_t *up;
     CLV() : score(0), isDup(false), isRoot(false), up(nullptr) {}
   };
 
   std::vector<CLV> _clvs;
+  // global species ID of each bit of the clade bitsets
+  std::vector<unsigned int> _localToSpecies;
+  // inverse of _localToSpecies, only used while tagging
+  std::vector<unsigned int> _speciesToLocal;
+  // number of words per clade bitset
+  unsigned int _cladeWords;
+  // _clades[nodeIndex * _cladeWords + i] is the i-th word of
+  // the species bitset under the directed node nodeIndex
+  std::vector<Word> _clades;
   std::vector<corax_unode_t *> _bestRoots;
-  void _tagNode(corax_unode_t *node, CLV &clv);
+  Word *_getClade(unsigned int nodeIndex) {
+    return &_clades[nodeIndex * _cladeWords];
+  }
+  void _tagNode(corax_unode_t *node, CLV &clv, Word *clade);
   void _rootFromNode(corax_unode_t *node);
 
   struct TaggerUNodePrinter {
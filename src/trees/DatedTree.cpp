@@ -1,12 +1,25 @@
 #include "DatedTree.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 
 #include <maths/Random.hpp>
 
+/**
+ *  Pseudo-random key of the (node, rank) pair, from the
+ *  splitmix64 finalizer
+ */
+static uint64_t getRankKey(unsigned int nodeIndex, unsigned int rank) {
+  uint64_t x = (static_cast<uint64_t>(nodeIndex) << 32) | rank;
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
 DatedTree::DatedTree(PLLRootedTree &rootedTree, bool useBLs)
-    : _fromBL(useBLs), _rootedTree(rootedTree) {
+    : _fromBL(useBLs), _rootedTree(rootedTree), _fingerprint(0) {
   // get _orderedSpeciations and _ranks either from tree topology
   // or from branch lengths
   _ranks.resize(_rootedTree.getNodeNumber(), 0);
@@ -32,6 +45,14 @@ void DatedTree::updateSpeciationOrderAndRanks() {
   for (auto node : _orderedSpeciations) {
     _ranks[node->node_index] = rank++;
   }
+  updateFingerprint();
+}
+
+void DatedTree::updateFingerprint() {
+  _fingerprint = 0;
+  for (unsigned int i = 0; i < _ranks.size(); ++i) {
+    _fingerprint ^= getRankKey(i, _ranks[i]);
+  }
 }
 
 void DatedTree::rescaleBranchLengths() {
@@ -84,6 +105,42 @@ bool DatedTree::moveDown(unsigned int rank) {
   _orderedSpeciations[rank] = n2;
   _ranks[n1->node_index]++;
   _ranks[n2->node_index]--;
+  _fingerprint ^= getRankKey(n1->node_index, rank) ^
+                  getRankKey(n1->node_index, rank + 1) ^
+                  getRankKey(n2->node_index, rank + 1) ^
+                  getRankKey(n2->node_index, rank);
+  return true;
+}
+
+bool DatedTree::getFeasibleRanks(unsigned int rank, unsigned int &minRank,
+                                 unsigned int &maxRank) const {
+  assert(_fromBL);
+  auto node = _orderedSpeciations[rank];
+  if (!node->left || !node->parent) {
+    return false;
+  }
+  minRank = _ranks[node->parent->node_index] + 1;
+  maxRank = std::min(_ranks[node->left->node_index],
+                     _ranks[node->right->node_index]) -
+            1;
+  // leaves come after all speciations
+  maxRank = std::min(maxRank, _rootedTree.getInnerNodeNumber() - 1);
+  return true;
+}
+
+bool DatedTree::moveTo(unsigned int rank, unsigned int newRank) {
+  unsigned int minRank = 0;
+  unsigned int maxRank = 0;
+  if (!getFeasibleRanks(rank, minRank, maxRank) || newRank < minRank ||
+      newRank > maxRank) {
+    return false;
+  }
+  for (; rank > newRank; --rank) {
+    moveUp(rank);
+  }
+  for (; rank < newRank; ++rank) {
+    moveDown(rank);
+  }
   return true;
 }
 
@@ -110,9 +167,9 @@ void DatedTree::restore(const DatedBackup &backup) {
   for (auto node : speciations) {
     _orderedSpeciations[_ranks[node->node_index]] = node;
   }
+  updateFingerprint();
 }
 
-// TODO: Too high hash collision rate! Fix somehow before using!
 // taken from https://stackoverflow.com/a/27952689
 static size_t hash_combine(size_t lhs, size_t rhs) {
   lhs ^= rhs + 0x9e3779b9 + (lhs << 6) + (lhs >> 2);
@@ -122,11 +179,8 @@ static size_t hash_combine(size_t lhs, size_t rhs) {
 size_t DatedTree::getOrderingHash(size_t startingHash) const {
   assert(_fromBL);
   std::hash<size_t> hash_fn;
-  size_t hash = hash_fn(startingHash);
-  for (auto rank : _ranks) {
-    hash = hash_combine(rank, hash);
-  }
-  return hash;
+  return hash_combine(static_cast<size_t>(_fingerprint),
+                      hash_fn(startingHash));
 }
 
 bool DatedTree::canTransferUnderRelDated(unsigned int e, unsigned int d) const {
@@ -162,4 +216,5 @@ void DatedTree::randomize() {
       toAdd.pop_back();
     }
   }
+  updateFingerprint();
 }
@@ -2,6 +2,8 @@
 
 #include "PLLRootedTree.hpp"
 
+#include <cstdint>
+
 /**
  *  Wrapper around PLLRootedTree handling the order of speciations
  */
@@ -31,6 +33,21 @@ public:
   bool moveUp(unsigned int rank);
   bool moveDown(unsigned int rank);
 
+  /**
+   *  Range [minRank, maxRank] of the ranks that the speciation with
+   *  the given rank can take, given the ranks of its parent and
+   *  children. Return false if rank is not a speciation.
+   */
+  bool getFeasibleRanks(unsigned int rank, unsigned int &minRank,
+                        unsigned int &maxRank) const;
+
+  /**
+   *  Move the speciation with the given rank to newRank, shifting
+   *  the speciations in between by one rank. Return false (and do
+   *  nothing) if newRank is not feasible.
+   */
+  bool moveTo(unsigned int rank, unsigned int newRank);
+
   void restore(const DatedBackup &backup);
 
   bool canTransferUnderRelDated(unsigned int e, unsigned int d) const;
@@ -42,8 +59,16 @@ public:
    */
   size_t getOrderingHash(size_t startingHash = 42) const;
 
+  /**
+   *  64 bits fingerprint of the current ranks (Zobrist hashing:
+   *  xor of one pseudo-random key per (node, rank) pair). It is
+   *  updated in O(1) by moveUp and moveDown.
+   */
+  uint64_t getOrderingFingerprint() const { return _fingerprint; }
+
 private:
   void checkRanks() const;
+  void updateFingerprint();
 
 private:
   const bool _fromBL;
@@ -52,4 +77,5 @@ private:
   std::vector<corax_rnode_t *> _orderedSpeciations;
   // ranks for all nodes, parents always have a lower rank than their children
   std::vector<unsigned int> _ranks;
+  uint64_t _fingerprint;
 };
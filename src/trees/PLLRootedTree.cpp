@@ -215,6 +215,44 @@ PLLRootedTree::PLLRootedTree(const std::string &str, bool isFile)
   setMissingBranchLengths();
 }
 
+PLLRootedTree::PLLRootedTree(corax_rtree_t *rtree)
+    : _tree(rtree, rtreeDestroy) {
+  ensureUniqueLabels();
+  setMissingBranchLengths();
+}
+
+/**
+ *  Copy the topology, labels and branch lengths of rtree, such that
+ *  each node keeps its node_index (node data is not copied)
+ */
+static corax_rtree_t *cloneRtree(const corax_rtree_t *rtree) {
+  auto nodesNumber = rtree->tip_count + rtree->inner_count;
+  auto res = static_cast<corax_rtree_t *>(xmalloc(sizeof(corax_rtree_t)));
+  *res = *rtree;
+  res->nodes = static_cast<corax_rnode_t **>(
+      xmalloc(nodesNumber * sizeof(corax_rnode_t *)));
+  for (unsigned int i = 0; i < nodesNumber; ++i) {
+    assert(rtree->nodes[i]->node_index == i);
+    res->nodes[i] =
+        static_cast<corax_rnode_t *>(xmalloc(sizeof(corax_rnode_t)));
+  }
+  auto getCopy = [res](const corax_rnode_t *node) {
+    return node ? res->nodes[node->node_index] : nullptr;
+  };
+  for (unsigned int i = 0; i < nodesNumber; ++i) {
+    auto node = rtree->nodes[i];
+    auto copy = res->nodes[i];
+    *copy = *node;
+    copy->label = node->label ? xstrdup(node->label) : nullptr;
+    copy->left = getCopy(node->left);
+    copy->right = getCopy(node->right);
+    copy->parent = getCopy(node->parent);
+    copy->data = nullptr;
+  }
+  res->root = getCopy(rtree->root);
+  return res;
+}
+
 PLLRootedTree::PLLRootedTree(const std::unordered_set<std::string> &labels)
     : _tree(buildRandomTree(labels), rtreeDestroy) {
   ensureUniqueLabels();
@@ -232,6 +270,10 @@ PLLRootedTree::buildFromStrOrFile(const std::string &strOrFile) {
   return res;
 }
 
+std::unique_ptr<PLLRootedTree> PLLRootedTree::clone() const {
+  return std::make_unique<PLLRootedTree>(cloneRtree(_tree.get()));
+}
+
 std::string
 PLLRootedTree::getRootedNewickFromOutgroup(corax_unode_t *outgroup) {
   auto rootedNewick = std::string("(");
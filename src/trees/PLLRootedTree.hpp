@@ -52,6 +52,11 @@ public:
    */
   PLLRootedTree(const std::string &str, bool isFile = true);
 
+  /**
+   *  Take the ownership of an already parsed libpll tree
+   */
+  explicit PLLRootedTree(corax_rtree_t *rtree);
+
   /**
    *  Construct a random tree from a set of taxa labels
    */
@@ -67,6 +72,13 @@ public:
   buildFromOutgroup(corax_unode_t *outgroup);
   static std::string getRootedNewickFromOutgroup(corax_unode_t *outgroup);
 
+  /**
+   *  Return a structural copy of this tree (topology, labels and
+   *  branch lengths), without going through a newick string.
+   *  Each node of the copy has the same node_index as in this tree.
+   */
+  std::unique_ptr<PLLRootedTree> clone() const;
+
   /**
    * Forbid copy
    */
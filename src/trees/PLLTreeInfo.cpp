@@ -9,7 +9,7 @@
 #include <corax/corax.h>
 const double DEFAULT_BL = 0.1;
 
-static unsigned int getBestLibpllAttribute() {
+static unsigned int computeBestLibpllAttribute() {
   corax_hardware_probe();
   unsigned int arch = CORAX_ATTRIB_ARCH_CPU;
   if (corax_hardware.avx2_present) {
@@ -23,6 +23,12 @@ static unsigned int getBestLibpllAttribute() {
   return arch;
 }
 
+static unsigned int getBestLibpllAttribute() {
+  // the hardware does not change, only probe it once
+  static const unsigned int attribute = computeBestLibpllAttribute();
+  return attribute;
+}
+
 void treeinfoDestroy(corax_treeinfo_t *treeinfo) {
   if (!treeinfo)
     return;
@@ -33,8 +39,14 @@ void treeinfoDestroy(corax_treeinfo_t *treeinfo) {
 PLLTreeInfo::PLLTreeInfo(const std::string &newickStrOrFile, bool isNewickAFile,
                          const std::string &alignmentFilename,
                          const std::string &modelStrOrFile)
+    : PLLTreeInfo(newickStrOrFile, isNewickAFile, alignmentFilename,
+                  *LibpllParsers::getModel(modelStrOrFile)) {}
+
+PLLTreeInfo::PLLTreeInfo(const std::string &newickStrOrFile, bool isNewickAFile,
+                         const std::string &alignmentFilename,
+                         const Model &model)
     : _treeinfo(nullptr, treeinfoDestroy),
-      _model(LibpllParsers::getModel(modelStrOrFile)) {
+      _model(std::make_unique<Model>(model)) {
   PLLSequencePtrs sequences;
   unsigned int *patternWeights = nullptr;
   LibpllParsers::parseMSA(alignmentFilename, _model->charmap(), sequences,
@@ -17,6 +17,12 @@ public:
               const std::string &alignmentFilename,
               const std::string &modelStrOrFile);
 
+  /**
+   *  Same as above, but copy an already parsed model
+   */
+  PLLTreeInfo(const std::string &newickStrOrFile, bool isNewickAFile,
+              const std::string &alignmentFilename, const Model &model);
+
   // forbid copy
   PLLTreeInfo(const PLLTreeInfo &) = delete;
   PLLTreeInfo &operator=(const PLLTreeInfo &) = delete;
@@ -3,13 +3,16 @@
 #include <IO/LibpllException.hpp>
 #include <IO/Logger.hpp>
 #include <corax/io/newick.hpp>
+#include <cassert>
 #include <corax/tree/utree_compare.h>
+#include <cstddef>
 #include <deque>
 #include <fstream>
 #include <functional>
 #include <sstream>
 #include <stack>
 #include <trees/PLLRootedTree.hpp>
+#include <unordered_map>
 
 void defaultUnodePrinter(corax_unode_t *node, std::stringstream &ss) {
   if (node->label) {
@@ -26,6 +29,114 @@ void utreeDestroy(corax_utree_t *utree) {
   corax_utree_destroy(utree, destroyNodeData);
 }
 
+/**
+ *  Compacted trees are stored in one memory block with the layout:
+ *  [CompactHeader][corax_utree_t][node pointers][nodes][labels]
+ *  Labels set after compaction are allocated separately.
+ */
+struct CompactHeader {
+  size_t blockSize;
+};
+
+static size_t alignSize(size_t size) {
+  const size_t alignment = alignof(std::max_align_t);
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static char *getCompactBlock(const corax_utree_t *utree) {
+  return reinterpret_cast<char *>(const_cast<corax_utree_t *>(utree)) -
+         alignSize(sizeof(CompactHeader));
+}
+
+static bool isInCompactBlock(const corax_utree_t *utree, const char *ptr) {
+  auto block = getCompactBlock(utree);
+  auto blockSize = reinterpret_cast<CompactHeader *>(block)->blockSize;
+  return ptr >= block && ptr < block + blockSize;
+}
+
+static unsigned int getDirectedNodeNumber(const corax_utree_t *utree) {
+  return utree->tip_count + 3 * utree->inner_count;
+}
+
+static void compactUtreeDestroy(corax_utree_t *utree) {
+  if (!utree)
+    return;
+  std::unordered_set<char *> externalLabels;
+  auto nodes = reinterpret_cast<corax_unode_t *>(utree->nodes +
+                                                 utree->tip_count +
+                                                 utree->inner_count);
+  for (unsigned int i = 0; i < getDirectedNodeNumber(utree); ++i) {
+    auto label = nodes[i].label;
+    if (label && !isInCompactBlock(utree, label)) {
+      externalLabels.insert(label);
+    }
+  }
+  for (auto label : externalLabels) {
+    free(label);
+  }
+  free(getCompactBlock(utree));
+}
+
+static corax_utree_t *buildCompactUtree(const corax_utree_t *utree) {
+  auto nodesNumber = utree->tip_count + utree->inner_count;
+  auto directedNodesNumber = getDirectedNodeNumber(utree);
+  std::vector<corax_unode_t *> oldNodes(directedNodesNumber, nullptr);
+  for (unsigned int i = 0; i < nodesNumber; ++i) {
+    auto node = utree->nodes[i];
+    do {
+      assert(node->node_index < directedNodesNumber);
+      oldNodes[node->node_index] = node;
+      node = node->next;
+    } while (node && node != utree->nodes[i]);
+  }
+  // labels shared by several nodes are only stored once
+  std::unordered_map<const char *, size_t> labelOffsets;
+  size_t labelsSize = 0;
+  for (auto node : oldNodes) {
+    assert(node);
+    if (node->label && !labelOffsets.count(node->label)) {
+      labelOffsets[node->label] = labelsSize;
+      labelsSize += strlen(node->label) + 1;
+    }
+  }
+  auto headerSize = alignSize(sizeof(CompactHeader));
+  auto treeSize = alignSize(sizeof(corax_utree_t));
+  auto pointersSize = alignSize(nodesNumber * sizeof(corax_unode_t *));
+  auto unodesSize = alignSize(directedNodesNumber * sizeof(corax_unode_t));
+  auto blockSize = headerSize + treeSize + pointersSize + unodesSize +
+                   labelsSize;
+  auto block = static_cast<char *>(malloc(blockSize));
+  if (!block) {
+    throw LibpllException("Can't allocate memory for the tree");
+  }
+  reinterpret_cast<CompactHeader *>(block)->blockSize = blockSize;
+  auto res = reinterpret_cast<corax_utree_t *>(block + headerSize);
+  auto pointers =
+      reinterpret_cast<corax_unode_t **>(block + headerSize + treeSize);
+  auto unodes = reinterpret_cast<corax_unode_t *>(block + headerSize +
+                                                  treeSize + pointersSize);
+  auto labels = block + headerSize + treeSize + pointersSize + unodesSize;
+  for (auto &labelOffset : labelOffsets) {
+    strcpy(labels + labelOffset.second, labelOffset.first);
+  }
+  for (unsigned int i = 0; i < directedNodesNumber; ++i) {
+    auto oldNode = oldNodes[i];
+    auto &node = unodes[i];
+    node = *oldNode;
+    node.label = oldNode->label ? labels + labelOffsets[oldNode->label]
+                                : nullptr;
+    node.next = oldNode->next ? &unodes[oldNode->next->node_index] : nullptr;
+    node.back = &unodes[oldNode->back->node_index];
+  }
+  *res = *utree;
+  res->nodes = pointers;
+  for (unsigned int i = 0; i < nodesNumber; ++i) {
+    pointers[i] = &unodes[utree->nodes[i]->node_index];
+  }
+  res->vroot = utree->vroot ? &unodes[utree->vroot->node_index] : nullptr;
+  return res;
+}
+
 static corax_utree_t *readNewickFromStr(const std::string &str) {
   corax_newick_parser_t parser(str);
   auto utree = parser.parse(true, true);
@@ -60,6 +171,11 @@ PLLUnrootedTree::PLLUnrootedTree(const std::string &str, bool isFile)
   setMissingBranchLengths();
 }
 
+PLLUnrootedTree::PLLUnrootedTree(corax_utree_t *utree)
+    : _tree(utree, utreeDestroy) {
+  setMissingBranchLengths();
+}
+
 PLLUnrootedTree::PLLUnrootedTree(PLLRootedTree &rootedTree)
     : _tree(corax_rtree_unroot(rootedTree.getRawPtr()), utreeDestroy) {
   corax_unode_t *root = _tree->nodes[_tree->tip_count + _tree->inner_count - 1];
@@ -117,14 +233,35 @@ char *consensus_serialize(const corax_unode_t *node) {
 }
 
 static void setNodeLabel(corax_unode_t *node, const std::string &label) {
-  free(node->label);
   node->label = static_cast<char *>(malloc(sizeof(char) * (label.size() + 1)));
   std::strcpy(node->label, label.c_str());
 }
 
 void PLLUnrootedTree::setLabel(unsigned int nodeIndex,
                                const std::string &label) {
-  setNodeLabel(getNode(nodeIndex), label);
+  auto node = getNode(nodeIndex);
+  freeLabel(node);
+  setNodeLabel(node, label);
+}
+
+bool PLLUnrootedTree::isCompacted() const {
+  return _tree.get_deleter() == compactUtreeDestroy;
+}
+
+void PLLUnrootedTree::freeLabel(corax_unode_t *node) {
+  if (!isCompacted() || !node->label ||
+      !isInCompactBlock(_tree.get(), node->label)) {
+    free(node->label);
+  }
+  node->label = nullptr;
+}
+
+void PLLUnrootedTree::compact() {
+  if (isCompacted()) {
+    return;
+  }
+  _tree = std::unique_ptr<corax_utree_t, void (*)(corax_utree_t *)>(
+      buildCompactUtree(_tree.get()), compactUtreeDestroy);
 }
 
 std::string
@@ -883,10 +1020,8 @@ void PLLUnrootedTree::ensureUniqueLabels() {
       while (labels.find(newLabel) != labels.end() || newLabel.size() == 0) {
         newLabel = prefix + std::to_string(i++);
       }
-      free(node->label);
-      node->label =
-          static_cast<char *>(malloc(sizeof(char) * (newLabel.size() + 1)));
-      std::strcpy(node->label, newLabel.c_str());
+      freeLabel(node);
+      setNodeLabel(node, newLabel);
       labels.insert(newLabel);
     }
   }
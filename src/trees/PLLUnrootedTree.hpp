@@ -30,6 +30,11 @@ public:
    */
   PLLUnrootedTree(const std::string &str, bool isFile = true);
 
+  /**
+   *  Take the ownership of an already parsed libpll tree
+   */
+  explicit PLLUnrootedTree(corax_utree_t *utree);
+
   /**
    *  Construct an unrooted tree from a rooted tree (we simply
    *  unroot it)
@@ -142,6 +147,15 @@ public:
    */
   void setMissingBranchLengths(double minBL = 0.1);
 
+  /**
+   *  Move the tree structure (nodes and labels) into a single
+   *  contiguous memory block, with the nodes stored in node_index
+   *  order. This replaces the many small allocations made by the
+   *  parsers, and the whole block is released at once with the tree.
+   *  Node pointers obtained before this call become invalid.
+   */
+  void compact();
+
   size_t getUnrootedTreeHash() const;
   size_t getRootedTreeHash(corax_unode_t *root) const;
   /**
@@ -258,6 +272,10 @@ public:
 private:
   std::unique_ptr<corax_utree_t, void (*)(corax_utree_t *)> _tree;
 
+  bool isCompacted() const;
+  // free the label of node, unless it is stored in the compacted block
+  void freeLabel(corax_unode_t *node);
+
   static bool areIsomorphic(const PLLUnrootedTree &t1,
                             const PLLUnrootedTree &t2);
 };
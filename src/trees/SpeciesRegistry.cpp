@@ -0,0 +1,25 @@
+#include "SpeciesRegistry.hpp"
+
+#include <IO/LibpllException.hpp>
+#include <trees/PLLRootedTree.hpp>
+
+SpeciesRegistry::SpeciesRegistry(const PLLRootedTree &tree)
+    : _idToLabel(tree.getDeterministicIdToLabel()),
+      _idToNode(tree.getNodeNumber()), _nodeToId(tree.getNodeNumber()) {
+  for (unsigned int id = 0; id < _idToLabel.size(); ++id) {
+    _labelToId[_idToLabel[id]] = id;
+  }
+  for (auto node : tree.getNodes()) {
+    auto id = _labelToId.at(std::string(node->label));
+    _idToNode[id] = node->node_index;
+    _nodeToId[node->node_index] = id;
+  }
+}
+
+unsigned int SpeciesRegistry::getIdFromLabel(const std::string &label) const {
+  auto it = _labelToId.find(label);
+  if (it == _labelToId.end()) {
+    throw LibpllException("Unknown species label ", label);
+  }
+  return it->second;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <util/types.hpp>
+#include <vector>
+
+class PLLRootedTree;
+
+/**
+ *  Deterministic IDs for the nodes of a species tree: the ID of a
+ *  node is the rank of its label in lexicographic order, such that
+ *  the IDs do not depend on the node indices and are the same on all
+ *  parallel ranks (see PLLRootedTree::getDeterministicIdToLabel).
+ *
+ *  All translations between IDs, labels and node indices are
+ *  precomputed, and the translations from IDs and node indices are
+ *  simple array accesses.
+ */
+class SpeciesRegistry {
+public:
+  explicit SpeciesRegistry(const PLLRootedTree &tree);
+
+  unsigned int getSpeciesNumber() const { return _idToLabel.size(); }
+
+  const std::string &getLabel(unsigned int id) const { return _idToLabel[id]; }
+  unsigned int getNodeIndex(unsigned int id) const { return _idToNode[id]; }
+  unsigned int getIdFromNodeIndex(unsigned int nodeIndex) const {
+    return _nodeToId[nodeIndex];
+  }
+  /**
+   *  Throws a LibpllException if the label is unknown
+   */
+  unsigned int getIdFromLabel(const std::string &label) const;
+  unsigned int getNodeIndexFromLabel(const std::string &label) const {
+    return getNodeIndex(getIdFromLabel(label));
+  }
+
+  const std::vector<std::string> &getIdToLabel() const { return _idToLabel; }
+
+private:
+  std::vector<std::string> _idToLabel;
+  std::vector<unsigned int> _idToNode;
+  std::vector<unsigned int> _nodeToId;
+  StringToUint _labelToId;
+};
@@ -20,15 +20,42 @@ getLabelsFromFamilies(const Families &families) {
   return leafLabels;
 }
 
+void SpeciesTreeChange::addTopologyChange(
+    const std::unordered_set<corax_rnode_t *> *nodes) {
+  // several topology changes are not a single SPR move anymore
+  sprPrune = sprOldBrother = sprNewBrother = nullptr;
+  topology = true;
+  if (!nodes) {
+    allNodes = true;
+    nodesToInvalidate.clear();
+  } else if (!allNodes) {
+    nodesToInvalidate.insert(nodes->begin(), nodes->end());
+  }
+}
+
+void SpeciesTreeChange::addSPRChange(
+    corax_rnode_t *prune, corax_rnode_t *oldBrother, corax_rnode_t *newBrother,
+    const std::unordered_set<corax_rnode_t *> &nodes) {
+  bool first = !topology;
+  addTopologyChange(&nodes);
+  if (first) {
+    sprPrune = prune;
+    sprOldBrother = oldBrother;
+    sprNewBrother = newBrother;
+  }
+}
+
 SpeciesTree::SpeciesTree(const std::string &str, bool isFile, bool useBLs)
-    : _speciesTree(str, isFile), _datedTree(_speciesTree, useBLs) {}
+    : _speciesTree(str, isFile), _datedTree(_speciesTree, useBLs),
+      _transactionDepth(0) {}
 
 SpeciesTree::SpeciesTree(const std::unordered_set<std::string> &labels)
-    : _speciesTree(labels), _datedTree(_speciesTree, false) {}
+    : _speciesTree(labels), _datedTree(_speciesTree, false),
+      _transactionDepth(0) {}
 
 SpeciesTree::SpeciesTree(const Families &families)
     : _speciesTree(getLabelsFromFamilies(families)),
-      _datedTree(_speciesTree, false) {}
+      _datedTree(_speciesTree, false), _transactionDepth(0) {}
 
 std::unique_ptr<SpeciesTree> SpeciesTree::buildRandomTree() const {
   return std::make_unique<SpeciesTree>(_speciesTree.getLabels(true));
@@ -42,11 +69,11 @@ void SpeciesTree::saveToFile(const std::string &fileName,
   _speciesTree.save(fileName);
 }
 
-void SpeciesTree::getLabelToId(StringToUint &labelToId) const {
-  labelToId.clear();
-  for (auto node : getTree().getNodes()) {
-    labelToId[std::string(node->label)] = node->node_index;
+const SpeciesRegistry &SpeciesTree::getSpeciesRegistry() const {
+  if (!_registry) {
+    _registry = std::make_unique<SpeciesRegistry>(_speciesTree);
   }
+  return *_registry;
 }
 
 void SpeciesTree::addListener(Listener *listener) {
@@ -58,19 +85,67 @@ void SpeciesTree::removeListener(Listener *listener) {
                    _listeners.end());
 }
 
+void SpeciesTree::Listener::onChange(const SpeciesTreeChange &change) {
+  if (change.topology) {
+    onSpeciesTreeChange(change.getNodesToInvalidate());
+  }
+  if (change.dates) {
+    onSpeciesDatesChange();
+  }
+}
+
 void SpeciesTree::onSpeciesDatesChange() {
-  _datedTree.rescaleBranchLengths(); // update branch lengths
-  for (auto listener : _listeners) {
-    listener->onSpeciesDatesChange();
+  _pendingChange.dates = true;
+  if (!_transactionDepth) {
+    deliverChange();
   }
 }
 
 void SpeciesTree::onSpeciesTreeChange(
     const std::unordered_set<corax_rnode_t *> *nodesToInvalidate) {
-  _datedTree.rescaleBranchLengths();                   // update branch lengths
-  _speciesTree.onSpeciesTreeChange(nodesToInvalidate); // update labels and lcas
+  _pendingChange.addTopologyChange(nodesToInvalidate);
+  if (!_transactionDepth) {
+    deliverChange();
+  }
+}
+
+void SpeciesTree::onSpeciesTreeSPR(
+    corax_rnode_t *prune, corax_rnode_t *oldBrother, corax_rnode_t *newBrother,
+    const std::unordered_set<corax_rnode_t *> &nodesToInvalidate) {
+  _pendingChange.addSPRChange(prune, oldBrother, newBrother,
+                              nodesToInvalidate);
+  if (!_transactionDepth) {
+    deliverChange();
+  }
+}
+
+void SpeciesTree::deliverChange() {
+  if (_pendingChange.empty()) {
+    return;
+  }
+  // the listeners might trigger new changes
+  SpeciesTreeChange change;
+  std::swap(change, _pendingChange);
+  _datedTree.rescaleBranchLengths(); // update branch lengths
+  if (change.topology) {
+    // update labels and lcas
+    _speciesTree.onSpeciesTreeChange(change.getNodesToInvalidate());
+    _registry.reset();
+  }
   for (auto listener : _listeners) {
-    listener->onSpeciesTreeChange(nodesToInvalidate);
+    listener->onChange(change);
+  }
+}
+
+SpeciesTree::ChangeTransaction::ChangeTransaction(SpeciesTree &speciesTree)
+    : _speciesTree(speciesTree) {
+  _speciesTree._transactionDepth++;
+}
+
+SpeciesTree::ChangeTransaction::~ChangeTransaction() {
+  assert(_speciesTree._transactionDepth);
+  if (!--_speciesTree._transactionDepth) {
+    _speciesTree.deliverChange();
   }
 }
 
@@ -206,7 +281,8 @@ unsigned int SpeciesTreeOperator::applySPRMove(SpeciesTree &speciesTree,
   auto &datedTree = speciesTree.getDatedTree();
   assert(!datedTree.isDated());
   datedTree.updateSpeciationOrderAndRanks(); // get ranks from topology
-  speciesTree.onSpeciesTreeChange(&nodesToInvalidate);
+  speciesTree.onSpeciesTreeSPR(pruneNode, pruneBrotherNode, regraftNode,
+                               nodesToInvalidate);
   return res;
 }
 
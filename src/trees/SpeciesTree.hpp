@@ -4,9 +4,50 @@
 
 #include "DatedTree.hpp"
 #include "PLLRootedTree.hpp"
+#include "SpeciesRegistry.hpp"
 #include <IO/Families.hpp>
 #include <util/types.hpp>
 
+/**
+ *  Description of the pending changes of a species tree, accumulated
+ *  until they are delivered to the listeners
+ */
+struct SpeciesTreeChange {
+  SpeciesTreeChange()
+      : topology(false), allNodes(false), dates(false), sprPrune(nullptr),
+        sprOldBrother(nullptr), sprNewBrother(nullptr) {}
+
+  // the topology (or the root) changed
+  bool topology;
+  // nodes whose children changed. Their ancestors are affected too
+  std::unordered_set<corax_rnode_t *> nodesToInvalidate;
+  // all nodes are affected (nodesToInvalidate is then ignored)
+  bool allNodes;
+  // the node dates (speciation order) changed
+  bool dates;
+  // if the topology change is a single SPR move: the pruned subtree,
+  // and its sibling before and after the move. Null otherwise
+  corax_rnode_t *sprPrune;
+  corax_rnode_t *sprOldBrother;
+  corax_rnode_t *sprNewBrother;
+
+  bool empty() const { return !topology && !dates; }
+  bool isSingleSPR() const { return sprPrune != nullptr; }
+  void clear() { *this = SpeciesTreeChange(); }
+  void addTopologyChange(
+      const std::unordered_set<corax_rnode_t *> *nodesToInvalidate);
+  void
+  addSPRChange(corax_rnode_t *prune, corax_rnode_t *oldBrother,
+               corax_rnode_t *newBrother,
+               const std::unordered_set<corax_rnode_t *> &nodesToInvalidate);
+  /**
+   *  Argument to forward to the onSpeciesTreeChange callbacks
+   */
+  const std::unordered_set<corax_rnode_t *> *getNodesToInvalidate() const {
+    return allNodes ? nullptr : &nodesToInvalidate;
+  }
+};
+
 class SpeciesTree {
 public:
   SpeciesTree(const std::string &str, bool isFile, bool useBLs);
@@ -34,7 +75,11 @@ public:
   PLLRootedTree &getTree() { return _speciesTree; }
   DatedTree &getDatedTree() { return _datedTree; }
 
-  void getLabelToId(StringToUint &labelToId) const;
+  /**
+   *  Deterministic species IDs of the current tree. Rebuilt lazily
+   *  after topology changes, which can relabel internal nodes
+   */
+  const SpeciesRegistry &getSpeciesRegistry() const;
 
   size_t getHash() const;
   size_t getNodeIndexHash() const;
@@ -45,6 +90,11 @@ public:
     virtual void onSpeciesDatesChange() = 0;
     virtual void onSpeciesTreeChange(
         const std::unordered_set<corax_rnode_t *> *nodesToInvalidate) = 0;
+    /**
+     *  Called once per delivered change. The default implementation
+     *  forwards to the callbacks above (at most one call each)
+     */
+    virtual void onChange(const SpeciesTreeChange &change);
   };
   void addListener(Listener *listener);
   void removeListener(Listener *listener);
@@ -54,11 +104,37 @@ public:
   // should be called every time after changing the tree topology
   void onSpeciesTreeChange(
       const std::unordered_set<corax_rnode_t *> *nodesToInvalidate);
+  // same as above, for a topology change that is a single SPR move
+  void onSpeciesTreeSPR(
+      corax_rnode_t *prune, corax_rnode_t *oldBrother,
+      corax_rnode_t *newBrother,
+      const std::unordered_set<corax_rnode_t *> &nodesToInvalidate);
+
+  /**
+   *  While a ChangeTransaction is alive, the change notifications
+   *  are accumulated and delivered once, when the outermost
+   *  transaction ends. The tree must not be evaluated before that.
+   */
+  class ChangeTransaction {
+  public:
+    ChangeTransaction(SpeciesTree &speciesTree);
+    ~ChangeTransaction();
+    ChangeTransaction(const ChangeTransaction &) = delete;
+    ChangeTransaction &operator=(const ChangeTransaction &) = delete;
+
+  private:
+    SpeciesTree &_speciesTree;
+  };
 
 private:
+  void deliverChange();
+
   PLLRootedTree _speciesTree;
   DatedTree _datedTree;
   std::vector<Listener *> _listeners;
+  unsigned int _transactionDepth;
+  SpeciesTreeChange _pendingChange;
+  mutable std::unique_ptr<SpeciesRegistry> _registry;
 };
 
 class SpeciesTreeOperator {
@@ -33,6 +33,10 @@ struct RecModelInfo {
   // if the reconciliation model accounts for polytomies, branches
   // with lengths <= branchLengthThreshold will be contracted
   double branchLengthThreshold;
+  // if set to true, the UndatedDTL likelihood integrates over the
+  // binary resolutions of the polytomies obtained by contracting the
+  // branches shorter than branchLengthThreshold (PolytomyDTLModel)
+  bool integratePolytomies;
   // horizontal gene transfer constraint
   TransferConstaint transferConstraint;
   // disable duplications
@@ -47,6 +51,14 @@ struct RecModelInfo {
   // use less RAM, but likelihood evaluation might be slower
   // (specific to AleRax)
   bool memorySavings;
+  // if set to true, the species tree search integrates over the
+  // gene trees described by the conditional clade probabilities
+  // of each family instead of using a single gene tree
+  bool amalgamatedGeneTrees;
+  // per-rank memory budget for the reconciliation models, in MB.
+  // Models are released and rebuilt on demand to stay within the
+  // budget (0 for no budget)
+  unsigned int memoryBudget;
 
   /**
    *  Default constructor
@@ -56,9 +68,10 @@ struct RecModelInfo {
         perFamilyRates(true), gammaCategories(1),
         originationStrategy(OriginationStrategy::ROOT), pruneSpeciesTree(true),
         rootedGeneTree(true), forceGeneTreeRoot(false), madRooting(false),
-        branchLengthThreshold(-1.0),
+        branchLengthThreshold(-1.0), integratePolytomies(false),
         transferConstraint(TransferConstaint::PARENTS), noDup(false),
-        noDL(false), noTL(false), memorySavings(false) {}
+        noDL(false), noTL(false), memorySavings(false),
+        amalgamatedGeneTrees(false), memoryBudget(0) {}
 
   /**
    *  Constructor
@@ -77,9 +90,10 @@ struct RecModelInfo {
         pruneSpeciesTree(pruneSpeciesTree), rootedGeneTree(rootedGeneTree),
         forceGeneTreeRoot(forceGeneTreeRoot), madRooting(madRooting),
         branchLengthThreshold(branchLengthThreshold),
-        transferConstraint(transferConstraint), noDup(noDup), noDL(noDL),
-        noTL(noTL), fractionMissingFile(fractionMissingFile),
-        memorySavings(memorySavings) {}
+        integratePolytomies(false), transferConstraint(transferConstraint),
+        noDup(noDup), noDL(noDL), noTL(noTL),
+        fractionMissingFile(fractionMissingFile), memorySavings(memorySavings),
+        amalgamatedGeneTrees(false), memoryBudget(0) {}
 
   void readFromArgv(char **argv, int &i) {
     model = RecModel(atoi(argv[i++]));
@@ -101,6 +115,9 @@ struct RecModelInfo {
       fractionMissingFile = std::string();
     }
     memorySavings = bool(atoi(argv[i++]));
+    amalgamatedGeneTrees = bool(atoi(argv[i++]));
+    memoryBudget = static_cast<unsigned int>(atoi(argv[i++]));
+    integratePolytomies = bool(atoi(argv[i++]));
   }
 
   std::vector<std::string> getArgv() const {
@@ -126,10 +143,13 @@ struct RecModelInfo {
       argv.push_back(std::string("NONE"));
     }
     argv.push_back(std::to_string(static_cast<int>(memorySavings)));
+    argv.push_back(std::to_string(static_cast<int>(amalgamatedGeneTrees)));
+    argv.push_back(std::to_string(memoryBudget));
+    argv.push_back(std::to_string(static_cast<int>(integratePolytomies)));
     return argv;
   }
 
-  static int getArgc() { return 15; }
+  static int getArgc() { return 18; }
 
   std::vector<char> getParamTypes() const {
     std::vector<char> res;
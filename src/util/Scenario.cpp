@@ -380,21 +380,14 @@ void Scenario::saveReconciliation(ParallelOfstream &os,
   }
 }
 
-void Scenario::countTransfers(const StringToUint &labelToId,
+void Scenario::countTransfers(const SpeciesRegistry &registry,
                               MatrixUint &count) {
-  char *labelFrom = nullptr;
-  char *labelTo = nullptr;
-  unsigned int from = 0;
-  unsigned int to = 0;
   for (auto &event : _events) {
     switch (event.type) {
     case ReconciliationEventType::EVENT_T:
     case ReconciliationEventType::EVENT_TL:
-      labelFrom = _speciesTree->nodes[event.speciesNode]->label;
-      labelTo = _speciesTree->nodes[event.destSpeciesNode]->label;
-      from = labelToId.at(std::string(labelFrom));
-      to = labelToId.at(std::string(labelTo));
-      count[from][to]++;
+      count[registry.getIdFromNodeIndex(event.speciesNode)]
+           [registry.getIdFromNodeIndex(event.destSpeciesNode)]++;
       break;
     case ReconciliationEventType::EVENT_S:
     case ReconciliationEventType::EVENT_SL:
@@ -408,28 +401,26 @@ void Scenario::countTransfers(const StringToUint &labelToId,
   }
 }
 
-void Scenario::countOrigins(const StringToUint &labelToId,
+void Scenario::countOrigins(const SpeciesRegistry &registry,
                             std::vector<unsigned int> &fromS,
                             std::vector<unsigned int> &fromSButL,
                             MatrixUint &count) {
   // origins come from SL, S, T, and TL events
-  countTransfers(labelToId, count);
-  char *destLabel1 = nullptr;
-  char *destLabel2 = nullptr;
+  countTransfers(registry, count);
+  corax_rnode_t *speciesNode = nullptr;
   for (auto &event : _events) {
     switch (event.type) {
     case ReconciliationEventType::EVENT_S:
-      destLabel1 = _speciesTree->nodes[event.speciesNode]->left->label;
-      destLabel2 = _speciesTree->nodes[event.speciesNode]->right->label;
-      fromS[labelToId.at(destLabel1)]++;
-      fromS[labelToId.at(destLabel2)]++;
+      speciesNode = _speciesTree->nodes[event.speciesNode];
+      fromS[registry.getIdFromNodeIndex(speciesNode->left->node_index)]++;
+      fromS[registry.getIdFromNodeIndex(speciesNode->right->node_index)]++;
       break;
     case ReconciliationEventType::EVENT_SL:
-      destLabel1 = event.pllDestSpeciesNode->label;
-      destLabel2 = event.pllLostSpeciesNode->label;
-      assert(destLabel1 != destLabel2);
-      fromS[labelToId.at(destLabel1)]++;
-      fromSButL[labelToId.at(destLabel2)]++;
+      assert(event.pllDestSpeciesNode != event.pllLostSpeciesNode);
+      fromS[registry.getIdFromNodeIndex(
+          event.pllDestSpeciesNode->node_index)]++;
+      fromSButL[registry.getIdFromNodeIndex(
+          event.pllLostSpeciesNode->node_index)]++;
       break;
     case ReconciliationEventType::EVENT_T:
     case ReconciliationEventType::EVENT_TL:
@@ -509,13 +500,13 @@ void Scenario::saveTransferPairCountGlobal(
     PLLRootedTree &speciesTree,
     std::vector<std::shared_ptr<Scenario>> &scenarios,
     const std::string &filename) {
-  const auto labelToId = speciesTree.getDeterministicLabelToId();
-  const auto idToLabel = speciesTree.getDeterministicIdToLabel();
-  const unsigned int N = labelToId.size();
+  const SpeciesRegistry registry(speciesTree);
+  const auto &idToLabel = registry.getIdToLabel();
+  const unsigned int N = registry.getSpeciesNumber();
   const VectorUint zeros(N, 0);
   auto countMatrix = MatrixUint(N, zeros);
   for (auto &scenario : scenarios) {
-    scenario->countTransfers(labelToId, countMatrix);
+    scenario->countTransfers(registry, countMatrix);
   }
   std::vector<TransferPair> transferPairs;
   for (unsigned int i = 0; i < N; ++i) {
@@ -529,12 +520,10 @@ void Scenario::saveTransferPairCountGlobal(
   }
   unsigned int parentTransfers = 0;
   for (auto speciesNode : speciesTree.getNodes()) {
-    std::string fromLabel = speciesNode->label;
-    auto from = labelToId.at(fromLabel);
+    auto from = registry.getIdFromNodeIndex(speciesNode->node_index);
     auto parent = speciesNode;
     while (parent) {
-      std::string toLabel = parent->label;
-      auto to = labelToId.at(toLabel);
+      auto to = registry.getIdFromNodeIndex(parent->node_index);
       parentTransfers += countMatrix[from][to];
       parent = parent->parent;
     }
@@ -551,15 +540,15 @@ void Scenario::saveOriginsGlobal(
     PLLRootedTree &speciesTree,
     std::vector<std::shared_ptr<Scenario>> &scenarios, unsigned int samples,
     const std::string &outputDir) {
-  const auto labelToId = speciesTree.getDeterministicLabelToId();
-  const auto idToLabel = speciesTree.getDeterministicIdToLabel();
-  const unsigned int N = labelToId.size();
+  const SpeciesRegistry registry(speciesTree);
+  const auto &idToLabel = registry.getIdToLabel();
+  const unsigned int N = registry.getSpeciesNumber();
   const VectorUint zeros(N, 0);
   auto countMatrix = MatrixUint(N, zeros);
   std::vector<unsigned int> fromS(N, 0);
   std::vector<unsigned int> fromSButL(N, 0);
   for (auto &scenario : scenarios) {
-    scenario->countOrigins(labelToId, fromS, fromSButL, countMatrix);
+    scenario->countOrigins(registry, fromS, fromSButL, countMatrix);
   }
   // iterate over all dest species, and compute their origins
   for (unsigned int j = 0; j < N; ++j) {
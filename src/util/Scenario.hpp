@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <trees/PLLRootedTree.hpp>
+#include <trees/SpeciesRegistry.hpp>
 #include <unordered_set>
 #include <util/enums.hpp>
 #include <util/types.hpp>
@@ -166,8 +167,8 @@ public:
       const PLLRootedTree &tree, const std::string &filename,
       const std::vector<std::string> &filenames, bool parallel, bool normalize);
   void gatherReconciliationStatistics(PerSpeciesEvents &perSpeciesEvents) const;
-  void countTransfers(const StringToUint &labelToId, MatrixUint &count);
-  void countOrigins(const StringToUint &labelToId,
+  void countTransfers(const SpeciesRegistry &registry, MatrixUint &count);
+  void countOrigins(const SpeciesRegistry &registry,
                     std::vector<unsigned int> &fromS,
                     std::vector<unsigned int> &fromSButL, MatrixUint &count);
 